@@ -0,0 +1,602 @@
+/*
+ * bench: measures every algorithm on a suite of mazes
+ *
+ * Runs every entry of algorithms[] on the maze files given on the command
+ * line and on generated mazes of increasing size. Every case runs in a
+ * child process, so its peak memory is measured on its own, with a fixed
+ * seed, a number of warm-up runs and a number of measured runs. A run
+ * reads the maze (parse), builds the open masks and the walker
+ * (preprocess) and solves the maze (solve). Solving starts with the init
+ * of the solver, where the search solvers do their search, so init is
+ * part of the solve time and is also reported on its own.
+ *
+ * The results are written to stdout as JSON, one case per line. With -c
+ * the results are compared with a baseline written by an earlier run,
+ * regressions and the cases of the baseline that were not measured are
+ * printed to stderr. bench exits with 1 when a case failed or regressed.
+ *
+ * With -T every case is run at 1, 2, 4 ... THREADS threads, and the
+ * speedup and the efficiency of the solve time over 1 thread are added
+ * to the results, so the scaling of the parallel solvers can be seen.
+ *
+ * usage: bench [-r REPEATS] [-w WARMUP] [-s MAX_STEPS] [-g MAX_SIZE]
+ *              [-t THREADS] [-T] [-a ALGORITHM] [-c BASELINE]
+ *              [-p PERCENT] [--seed SEED] [MAZE_FILE...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <malloc.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "walkerdef.h"
+#include "mazedef.h"
+#include "maze.h"
+#include "solvers.h"
+#include "timing.h"
+#include "genmaze.h"
+
+/* the sides of the generated mazes */
+static const int gen_sizes[] = {101, 317, 1001, 3163};
+#define GEN_COUNT (sizeof(gen_sizes) / sizeof(gen_sizes[0]))
+
+/* a time difference below this many ms is never a regression */
+#define NOISE_MS 0.25
+/* a growth of the peak memory below this many KB is never a regression */
+#define NOISE_KB 1024
+
+/* the settings of the benchmark */
+static int repeats = 5;
+static int warmup = 1;
+static long max_steps = 10000000;
+static int max_size = 3163;
+static uint64_t seed = 1;
+static double percent = 25;
+/* 1 = run every case at 1, 2, 4 ... ss.threads threads */
+static int scaling = 0;
+/* the only algorithm to measure, NULL = all */
+static const char *only = NULL;
+
+/* the statistics of a measurement over the repeats, in ms */
+typedef struct stats_t {
+    double min, median, mean, sd;
+} stats_t;
+
+/* the results of a case, sent from the child to the parent */
+typedef struct result_t {
+    /* 1 = every run succeeded */
+    int ok;
+    int rows, cols;
+    /* the status and the steps of the last run, see run_status_t */
+    int status;
+    long steps;
+    stats_t parse, prep, solve, init;
+} result_t;
+
+/* the times of a single run in ms */
+typedef struct run_t {
+    double parse, prep, solve, init;
+} run_t;
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static stats_t stats(double *v, int n) {
+    stats_t s = {0};
+    qsort(v, n, sizeof(double), cmp_double);
+    s.min = v[0];
+    s.median = n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+    for (int i = 0; i < n; i++)
+        s.mean += v[i] / n;
+    for (int i = 0; i < n; i++)
+        s.sd += (v[i] - s.mean) * (v[i] - s.mean) / n;
+    s.sd = sqrt(s.sd);
+    return s;
+}
+
+/* runs algorithm a on the maze file fname once */
+static int run_once(const char *fname, algorithm_t *a, run_t *t,
+        result_t *r) {
+    ss_set_seed(seed);
+    double t0 = now_sec();
+    maze_t *m = read_maze(fname, 0);
+    if (!m)
+        return 0;
+    double t1 = now_sec();
+
+    walker_t *w = NULL;
+    int ok = build_open_masks(m) && (w = init_walker(m, a->funct));
+    double t2 = now_sec();
+    ok = ok && (!a->init || a->init(m, w) == INIT_OK);
+    double ti = now_sec();
+
+    long steps = 0;
+    if (ok && a->run) {
+        r->status = a->run(m, w, max_steps, &steps);
+    } else if (ok) {
+        r->status = RUN_BUDGET;
+        while (steps < max_steps) {
+            if (walker_step(m, w) < 0) {
+                r->status = RUN_HALT;
+                break;
+            }
+            steps++;
+            if (at_exit(m, w)) {
+                r->status = RUN_EXIT;
+                break;
+            }
+        }
+    }
+    double t3 = now_sec();
+
+    t->parse = (t1 - t0) * 1e3;
+    t->prep = (t2 - t1) * 1e3;
+    t->solve = (t3 - t2) * 1e3;
+    t->init = (ti - t2) * 1e3;
+    r->steps = steps;
+    r->rows = m->r;
+    r->cols = m->c;
+    if (w && a->free)
+        a->free(w->state);
+    if (w)
+        cleanup_walker(w);
+    cleanup_maze(m);
+    return ok;
+}
+
+/* runs a case in the child process and sends the result to fd */
+static void run_case(const char *fname, algorithm_t *a, int fd) {
+    /* the solvers and the maze reader talk, the results go to fd */
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    dup2(null, STDERR_FILENO);
+    /*
+     * a fixed threshold returns every large block to the system when it
+     * is freed, so the peak memory does not grow with the repeats
+     */
+    mallopt(M_MMAP_THRESHOLD, 128 * 1024);
+
+    result_t r = {0};
+    run_t *t = malloc(sizeof(run_t) * repeats);
+    double *v = malloc(sizeof(double) * repeats);
+    r.ok = t && v;
+    for (int i = 0; r.ok && i < warmup; i++)
+        r.ok = run_once(fname, a, t, &r);
+    for (int i = 0; r.ok && i < repeats; i++)
+        r.ok = run_once(fname, a, t + i, &r);
+    if (r.ok) {
+        for (int i = 0; i < repeats; i++)
+            v[i] = t[i].parse;
+        r.parse = stats(v, repeats);
+        for (int i = 0; i < repeats; i++)
+            v[i] = t[i].prep;
+        r.prep = stats(v, repeats);
+        for (int i = 0; i < repeats; i++)
+            v[i] = t[i].solve;
+        r.solve = stats(v, repeats);
+        for (int i = 0; i < repeats; i++)
+            v[i] = t[i].init;
+        r.init = stats(v, repeats);
+    }
+    ssize_t n = write(fd, &r, sizeof(r));
+    _exit(n == sizeof(r) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/*
+ * runs a case in a child process
+ * returns 1 on success and stores the peak memory of the child in rss
+ */
+static int measure(const char *fname, algorithm_t *a, result_t *r,
+        long *rss) {
+    int fds[2];
+    if (pipe(fds))
+        return 0;
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return 0;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        run_case(fname, a, fds[1]);
+    }
+    close(fds[1]);
+    ssize_t n = read(fds[0], r, sizeof(result_t));
+    close(fds[0]);
+
+    int status;
+    struct rusage ru;
+    if (wait4(pid, &status, 0, &ru) < 0 || !WIFEXITED(status)
+            || WEXITSTATUS(status) != EXIT_SUCCESS || n != sizeof(result_t))
+        return 0;
+    /* ru_maxrss is in KB */
+    *rss = ru.ru_maxrss;
+    return r->ok;
+}
+
+static void print_stats(const char *name, stats_t s) {
+    printf(", \"%s\": {\"min\": %.4f, \"median\": %.4f, \"mean\": %.4f, "
+            "\"sd\": %.4f}", name, s.min, s.median, s.mean, s.sd);
+}
+
+/*
+ * prints a case as a single line of JSON, speedup is the solve time on 1
+ * thread over the solve time on threads threads, 0 = unknown
+ */
+static void print_case(const char *maze, algorithm_t *a, int threads,
+        double speedup, result_t *r, long rss, int first) {
+    printf("%s    {\"maze\": \"%s\", \"algorithm\": \"%s\", \"threads\": %d, "
+            "\"rows\": %d, \"cols\": %d, \"exit\": %s, \"steps\": %ld, ",
+            first ? "" : ",\n", maze, a->name, threads, r->rows, r->cols,
+            r->status == RUN_EXIT ? "true" : "false", r->steps);
+    if (speedup > 0)
+        printf("\"speedup\": %.3f, \"efficiency\": %.3f, ", speedup,
+                speedup / threads);
+    if (r->status == RUN_EXIT)
+        printf("\"path_length\": %ld, ", r->steps);
+    else
+        printf("\"path_length\": null, ");
+    printf("\"steps_per_s\": %.0f, \"peak_rss_kb\": %ld",
+            r->solve.median > 0 ? r->steps / r->solve.median * 1e3 : 0.0,
+            rss);
+    print_stats("parse_ms", r->parse);
+    print_stats("preprocess_ms", r->prep);
+    print_stats("solve_ms", r->solve);
+    print_stats("init_ms", r->init);
+    printf("}");
+}
+
+/* the results of a case in a baseline */
+typedef struct base_t {
+    char maze[256], algo[64];
+    /* -1 when the baseline does not have the threads of its cases */
+    int threads;
+    long steps, rss;
+    stats_t parse, prep, solve;
+    /* 1 = the case was measured again */
+    int seen;
+} base_t;
+
+/* returns the number after "key": in line, or -1 when it is missing */
+static double json_num(const char *line, const char *key) {
+    char k[64];
+    snprintf(k, sizeof(k), "\"%s\": ", key);
+    const char *p = strstr(line, k);
+    return p ? strtod(p + strlen(k), NULL) : -1;
+}
+
+/* copies the string after "key": in line to s */
+static int json_str(const char *line, const char *key, char *s, size_t n) {
+    char k[64];
+    snprintf(k, sizeof(k), "\"%s\": \"", key);
+    const char *p = strstr(line, k);
+    if (!p)
+        return 0;
+    p += strlen(k);
+    const char *e = strchr(p, '"');
+    if (!e || (size_t) (e - p) >= n)
+        return 0;
+    memcpy(s, p, e - p);
+    s[e - p] = '\0';
+    return 1;
+}
+
+/* returns the minimum and the median of the statistics of key in line */
+static stats_t json_stats(const char *line, const char *key) {
+    char k[64];
+    stats_t s = {-1, -1, -1, -1};
+    snprintf(k, sizeof(k), "\"%s\": {", key);
+    const char *p = strstr(line, k);
+    if (p) {
+        s.min = json_num(p, "min");
+        s.median = json_num(p, "median");
+    }
+    return s;
+}
+
+/*
+ * reads the cases of a baseline written by bench
+ * returns the number of cases, -1 when the file can not be read
+ */
+static long read_baseline(const char *fname, base_t **cases) {
+    FILE *f = fopen(fname, "r");
+    if (!f)
+        return -1;
+    long n = 0, cap = 0;
+    char line[4096];
+    *cases = NULL;
+    while (fgets(line, sizeof(line), f)) {
+        base_t b = {0};
+        if (!json_str(line, "maze", b.maze, sizeof(b.maze))
+                || !json_str(line, "algorithm", b.algo, sizeof(b.algo)))
+            continue;
+        b.threads = json_num(line, "threads");
+        b.steps = json_num(line, "steps");
+        b.rss = json_num(line, "peak_rss_kb");
+        b.parse = json_stats(line, "parse_ms");
+        b.prep = json_stats(line, "preprocess_ms");
+        b.solve = json_stats(line, "solve_ms");
+        if (n == cap) {
+            cap = cap ? 2 * cap : 64;
+            base_t *c = realloc(*cases, sizeof(base_t) * cap);
+            if (!c) {
+                free(*cases);
+                fclose(f);
+                return -1;
+            }
+            *cases = c;
+        }
+        (*cases)[n++] = b;
+    }
+    fclose(f);
+    return n;
+}
+
+/*
+ * prints the cases of the baseline that were not measured, a case that
+ * fails or is left out can not be compared
+ * returns the number of those cases
+ */
+static int compare_missing(base_t *cases, long n) {
+    int found = 0;
+    for (long i = 0; i < n; i++) {
+        if (cases[i].seen)
+            continue;
+        fprintf(stderr, "REGRESSION %s %s", cases[i].maze, cases[i].algo);
+        if (scaling && cases[i].threads > 0)
+            fprintf(stderr, "/%d", cases[i].threads);
+        fprintf(stderr, ": in the baseline but not measured\n");
+        found++;
+    }
+    return found;
+}
+
+/* prints a regression of a time when there is one, returns 1 if so */
+static int time_regressed(const char *maze, const char *algo,
+        const char *what, stats_t base, stats_t now) {
+    /*
+     * both the fastest and the typical run must be slower, a few slow
+     * runs are noise
+     */
+    double limit = 1 + percent / 100;
+    if (base.min < 0 || now.min <= base.min * limit
+            || now.median <= base.median * limit
+            || now.median - base.median < NOISE_MS)
+        return 0;
+    fprintf(stderr, "REGRESSION %s %s: %s %.3f ms -> %.3f ms (+%.0f%%)\n",
+            maze, algo, what, base.median, now.median,
+            (now.median / base.median - 1) * 100);
+    return 1;
+}
+
+/*
+ * compares a case with the baseline
+ * returns the number of regressions
+ */
+static int compare(base_t *cases, long n, const char *maze, algorithm_t *a,
+        int threads, result_t *r, long rss) {
+    base_t *b = NULL;
+    for (long i = 0; i < n && !b; i++)
+        if (!strcmp(cases[i].maze, maze) && !strcmp(cases[i].algo, a->name)
+                && !cases[i].seen
+                && (cases[i].threads < 0 || cases[i].threads == threads))
+            b = cases + i;
+    /* a scaling run names the cases by the algorithm and the threads */
+    char name[80];
+    if (scaling)
+        snprintf(name, sizeof(name), "%s/%d", a->name, threads);
+    else
+        snprintf(name, sizeof(name), "%s", a->name);
+    if (!b) {
+        fprintf(stderr, "new case %s %s\n", maze, name);
+        return 0;
+    }
+    b->seen = 1;
+
+    int found = 0;
+    if (b->steps != r->steps) {
+        fprintf(stderr, "REGRESSION %s %s: took %ld steps instead of %ld\n",
+                maze, name, r->steps, b->steps);
+        found++;
+    }
+    found += time_regressed(maze, name, "parse", b->parse, r->parse);
+    found += time_regressed(maze, name, "preprocess", b->prep, r->prep);
+    found += time_regressed(maze, name, "solve", b->solve, r->solve);
+    if (b->rss > 0 && rss > b->rss * (1 + percent / 100)
+            && rss - b->rss > NOISE_KB) {
+        fprintf(stderr, "REGRESSION %s %s: peak memory %ld KB -> %ld KB\n",
+                maze, name, b->rss, rss);
+        found++;
+    }
+    return found;
+}
+
+static void usage(int status) {
+    fprintf(stderr,
+        "usage: bench [-r REPEATS] [-w WARMUP] [-s MAX_STEPS] [-g MAX_SIZE]"
+        " [-t THREADS] [-T] [-a ALGORITHM] [-c BASELINE] [-p PERCENT]"
+        " [--seed SEED] [MAZE_FILE...]\n\n"
+        "    -r REPEATS     the measured runs of every case, default %d\n"
+        "    -w WARMUP      the runs before the measured runs, default %d\n"
+        "    -s MAX_STEPS   the maximum steps of a run, default %ld\n"
+        "    -g MAX_SIZE    the largest side of the generated mazes,\n"
+        "                   default %d, 0 = no generated mazes\n"
+        "    -t THREADS     the threads a solver may use, default 1\n"
+        "    -T             runs every case at 1, 2, 4 ... THREADS threads\n"
+        "                   and reports the speedup and the efficiency\n"
+        "    -a ALGORITHM   only measures ALGORITHM\n"
+        "    -c BASELINE    compares the results with BASELINE, a file\n"
+        "                   written by bench, and exits with 1 when\n"
+        "                   something got slower or was not measured\n"
+        "    -p PERCENT     the slowdown that is a regression, default %.0f\n"
+        "    --seed SEED    the seed of the random walkers, default %llu\n",
+        repeats, warmup, max_steps, max_size, percent,
+        (unsigned long long) seed);
+    exit(status);
+}
+
+int main(int argc, char **argv) {
+    const char *baseline = NULL;
+    int c;
+    static const struct option longopts[] = {
+        {"seed", required_argument, NULL, 'S'},
+        {NULL, 0, NULL, 0},
+    };
+    while ((c = getopt_long(argc, argv, "hr:w:s:g:t:Ta:c:p:", longopts,
+                    NULL)) != -1) {
+        switch (c) {
+            case 'h':
+                usage(EXIT_SUCCESS);
+                break;
+            case 'r':
+                repeats = atoi(optarg);
+                break;
+            case 'w':
+                warmup = atoi(optarg);
+                break;
+            case 's':
+                max_steps = atol(optarg);
+                break;
+            case 'g':
+                max_size = atoi(optarg);
+                break;
+            case 't':
+                ss_set_threads(atoi(optarg));
+                break;
+            case 'T':
+                scaling = 1;
+                break;
+            case 'a':
+                only = optarg;
+                break;
+            case 'c':
+                baseline = optarg;
+                break;
+            case 'p':
+                percent = atof(optarg);
+                break;
+            case 'S':
+                seed = strtoull(optarg, NULL, 0);
+                break;
+            default:
+                usage(EXIT_FAILURE);
+        }
+    }
+    if (repeats < 1 || warmup < 0 || max_steps < 1)
+        usage(EXIT_FAILURE);
+    if (only && !get_algo(only)) {
+        fprintf(stderr, "Unknown algorithm '%s'\n", only);
+        return EXIT_FAILURE;
+    }
+
+    base_t *cases = NULL;
+    long ncases = 0;
+    if (baseline && (ncases = read_baseline(baseline, &cases)) < 0) {
+        fprintf(stderr, "Failed to read the baseline '%s'\n", baseline);
+        return EXIT_FAILURE;
+    }
+
+    /* the maze files and the generated mazes with their names */
+    int nfiles = argc - optind;
+    char (*gen)[32] = malloc(sizeof(*gen) * GEN_COUNT);
+    const char **files = malloc(sizeof(char *) * (nfiles + GEN_COUNT));
+    const char **names = malloc(sizeof(char *) * (nfiles + GEN_COUNT));
+    char (*gen_names)[32] = malloc(sizeof(*gen_names) * GEN_COUNT);
+    if (!gen || !files || !names || !gen_names) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+    int nmazes = 0;
+    for (int i = 0; i < nfiles; i++, nmazes++)
+        files[nmazes] = names[nmazes] = argv[optind + i];
+    int ngen = 0;
+    for (size_t i = 0; i < GEN_COUNT && gen_sizes[i] <= max_size; i++) {
+        strcpy(gen[ngen], "/tmp/bench_maze_XXXXXX");
+        int fd = mkstemp(gen[ngen]);
+        if (fd < 0 || close(fd)
+                || !write_maze(gen[ngen], gen_sizes[i], gen_sizes[i], seed)) {
+            fprintf(stderr, "Failed to generate a maze of %d * %d\n",
+                    gen_sizes[i], gen_sizes[i]);
+            return EXIT_FAILURE;
+        }
+        snprintf(gen_names[ngen], sizeof(gen_names[ngen]), "generated %dx%d",
+                gen_sizes[i], gen_sizes[i]);
+        files[nmazes] = gen[ngen];
+        names[nmazes++] = gen_names[ngen++];
+    }
+
+    printf("{\n  \"seed\": %llu, \"repeats\": %d, \"warmup\": %d, "
+            "\"max_steps\": %ld, \"threads\": %d,\n  \"cases\": [\n",
+            (unsigned long long) seed, repeats, warmup, max_steps,
+            ss.threads);
+    int max_threads = ss.threads;
+    int first = 1, regressions = 0, failed = 0;
+    for (int i = 0; i < nmazes; i++) {
+        for (algorithm_t *a = algorithms; a->name; a++) {
+            if (only && strcmp(only, a->name))
+                continue;
+            /* the solve time on 1 thread */
+            double single = 0;
+            int threads = scaling ? 1 : max_threads;
+            for (;;) {
+                result_t r;
+                long rss;
+                /* the child inherits the thread count */
+                ss_set_threads(threads);
+                fprintf(stderr, "%-24s %-14s %3d", names[i], a->name, threads);
+                if (measure(files[i], a, &r, &rss)) {
+                    double speedup = 0;
+                    if (threads == 1)
+                        single = r.solve.median;
+                    if (scaling && single > 0 && r.solve.median > 0)
+                        speedup = single / r.solve.median;
+                    fprintf(stderr, " %10.3f ms %10ld steps %8ld KB",
+                            r.solve.median, r.steps, rss);
+                    if (speedup > 0)
+                        fprintf(stderr, " %6.2fx %4.0f%%", speedup,
+                                speedup / threads * 100);
+                    fprintf(stderr, "\n");
+                    print_case(names[i], a, threads, speedup, &r, rss, first);
+                    first = 0;
+                    if (baseline)
+                        regressions += compare(cases, ncases, names[i], a,
+                                threads, &r, rss);
+                } else {
+                    fprintf(stderr, " failed\n");
+                    failed++;
+                }
+                if (threads == max_threads)
+                    break;
+                threads = threads * 2 < max_threads ? threads * 2 : max_threads;
+            }
+        }
+    }
+    ss_set_threads(max_threads);
+    printf("\n  ]\n}\n");
+    if (baseline)
+        regressions += compare_missing(cases, ncases);
+
+    for (int i = 0; i < ngen; i++)
+        unlink(gen[i]);
+    if (failed)
+        fprintf(stderr, "%d cases failed\n", failed);
+    if (baseline)
+        fprintf(stderr, "%d regressions against '%s'\n", regressions,
+                baseline);
+    free(cases);
+    free(gen);
+    free(gen_names);
+    free(files);
+    free(names);
+    return regressions || failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
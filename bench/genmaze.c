@@ -0,0 +1,73 @@
+/*
+ * Maze generator of the benchmarks
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "genmaze.h"
+#include "rng.h"
+
+int write_maze(const char *fname, int rows, int columns, uint64_t seed) {
+    int r = rows < 3 ? 3 : (rows - 1) | 1;
+    int c = columns < 3 ? 3 : (columns - 1) | 1;
+    /* the rooms are the tiles on odd rows and columns */
+    long rw = c / 2, rh = r / 2, n = rw * rh;
+
+    /* one row per line */
+    char *t = malloc((size_t) r * (c + 1));
+    long *stack = malloc(sizeof(long) * n);
+    if (!t || !stack) {
+        free(t);
+        free(stack);
+        return 0;
+    }
+    for (int y = 0; y < r; y++) {
+        memset(t + (size_t) y * (c + 1), '#', c);
+        t[(size_t) y * (c + 1) + c] = '\n';
+    }
+
+    /* depth first search from the first room, carving into the rooms
+     * that were not visited yet */
+    static const int dx[4] = {0, 1, 0, -1}, dy[4] = {-1, 0, 1, 0};
+    rng_t rng;
+    rng_seed(&rng, seed);
+    long top = 0;
+    stack[top++] = 0;
+    t[(size_t) 1 * (c + 1) + 1] = ' ';
+    while (top) {
+        long room = stack[top - 1];
+        int x = room % rw, y = room / rw;
+        int free_dirs[4], k = 0;
+        for (int d = 0; d < 4; d++) {
+            int nx = x + dx[d], ny = y + dy[d];
+            if (nx >= 0 && ny >= 0 && nx < rw && ny < rh
+                    && t[(size_t) (2 * ny + 1) * (c + 1) + 2 * nx + 1] == '#')
+                free_dirs[k++] = d;
+        }
+        if (!k) {
+            top--;
+            continue;
+        }
+        int d = free_dirs[rng_below(&rng, k)];
+        int nx = x + dx[d], ny = y + dy[d];
+        t[(size_t) (2 * y + 1 + dy[d]) * (c + 1) + 2 * x + 1 + dx[d]] = ' ';
+        t[(size_t) (2 * ny + 1) * (c + 1) + 2 * nx + 1] = ' ';
+        stack[top++] = (long) ny * rw + nx;
+    }
+    free(stack);
+
+    t[(size_t) 1 * (c + 1) + 1] = 'S';
+    t[(size_t) (r - 2) * (c + 1) + c - 2] = 'E';
+
+    FILE *f = fopen(fname, "w");
+    if (!f) {
+        free(t);
+        return 0;
+    }
+    fprintf(f, "%d,%d\n", r, c);
+    int ok = fwrite(t, 1, (size_t) r * (c + 1), f) == (size_t) r * (c + 1);
+    ok &= fclose(f) == 0;
+    free(t);
+    return ok;
+}
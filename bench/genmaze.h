@@ -0,0 +1,24 @@
+/*
+ * Maze generator of the benchmarks
+ *
+ * Writes perfect mazes, mazes with exactly one path between any two open
+ * tiles, in the format read by read_maze(). The same size and seed
+ * always give the same maze.
+ */
+
+#ifndef GENMAZE_H
+#define GENMAZE_H
+
+#include <stdint.h>
+
+/*
+ * Writes a maze of rows * columns tiles to the file fname, with the
+ * start in the top left and the exit in the bottom right corner.
+ * Even sizes are rounded down to odd ones, the smallest maze is 3 * 3.
+ *
+ * returns 1 on success
+ * returns 0 when the file can not be written or when out of memory
+ */
+int write_maze(const char *fname, int rows, int columns, uint64_t seed);
+
+#endif /* GENMAZE_H */
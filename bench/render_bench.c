@@ -0,0 +1,114 @@
+/*
+ * render_bench: measures how many frames per second the renderer draws
+ *
+ * Renders a wall follower walking through a maze, once redrawing every
+ * frame and once moving the walker a step between frames so only the
+ * changed cells are printed. The frames go to an unlinked temporary file
+ * so the bytes per frame can be counted, the results go to stderr.
+ *
+ * usage: render_bench [MAZE_FILE]
+ * Without a maze file a generated 1001 * 1001 maze is used.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "renderer.h"
+#include "walkerdef.h"
+#include "mazedef.h"
+#include "maze.h"
+#include "solvers.h"
+#include "timing.h"
+#include "genmaze.h"
+
+/* the time spent on every measurement in seconds */
+#define BENCH_TIME 1.0
+
+/* the screen sizes that are measured */
+static const int sizes[][2] = {{80, 24}, {400, 120}};
+
+/*
+ * renders frames for BENCH_TIME seconds, taking a step between frames
+ * when move is set and clearing the screen before every frame otherwise
+ */
+static void bench(maze_t *m, algorithm_t *a, int w, int h, int move) {
+    walker_t *walker = init_walker(m, a->funct);
+    if (!walker || (a->init && a->init(m, walker) != INIT_OK)) {
+        fprintf(stderr, "Failed to initialise '%s'\n", a->name);
+        exit(EXIT_FAILURE);
+    }
+    rs_set_dimensions(w, h);
+    rs_set_focus(&walker->pos);
+    clear_term();
+    render_maze(m, walker);
+    ftruncate(STDOUT_FILENO, 0);
+    lseek(STDOUT_FILENO, 0, SEEK_SET);
+
+    long frames = 0;
+    int err;
+    double t = now_sec(), end = t + BENCH_TIME;
+    do {
+        for (int i = 0; i < 16; i++, frames++) {
+            if (move) {
+                walker_step(m, walker);
+                if (at_exit(m, walker))
+                    place_walker(m, walker, maze_idx(m, m->start));
+            } else {
+                clear_term();
+            }
+            if ((err = render_maze(m, walker)) != MRSUCC) {
+                mrerror("Error while rendering", err);
+                exit(EXIT_FAILURE);
+            }
+        }
+    } while (now_sec() < end);
+    t = now_sec() - t;
+    off_t bytes = lseek(STDOUT_FILENO, 0, SEEK_CUR);
+
+    fprintf(stderr, "%4dx%-4d %-12s %10.0f frames/s %10.0f bytes/frame\n",
+            w, h, move ? "walker moves" : "full redraw", frames / t,
+            (double) bytes / frames);
+
+    if (a->free)
+        a->free(walker->state);
+    cleanup_walker(walker);
+}
+
+int main(int argc, char **argv) {
+    char gen[] = "/tmp/render_bench_XXXXXX";
+    const char *fname = argc > 1 ? argv[1] : NULL;
+    if (!fname) {
+        int fd = mkstemp(gen);
+        if (fd < 0 || close(fd) || !write_maze(gen, 1001, 1001, 1)) {
+            fprintf(stderr, "Failed to generate a maze\n");
+            return EXIT_FAILURE;
+        }
+        fname = gen;
+    }
+
+    maze_t *m = read_maze(fname, 0);
+    if (fname == gen)
+        unlink(gen);
+    if (!m) {
+        fprintf(stderr, "Error while reading maze file\n");
+        return EXIT_FAILURE;
+    }
+    build_open_masks(m);
+
+    /* the frames are counted, not shown */
+    FILE *out = tmpfile();
+    if (!out || dup2(fileno(out), STDOUT_FILENO) < 0) {
+        fprintf(stderr, "Failed to create a temporary file\n");
+        return EXIT_FAILURE;
+    }
+
+    algorithm_t *a = get_algo("wallfollower");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        bench(m, a, sizes[i][0], sizes[i][1], 0);
+        bench(m, a, sizes[i][0], sizes[i][1], 1);
+    }
+
+    cleanup_maze(m);
+    return EXIT_SUCCESS;
+}
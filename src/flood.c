@@ -0,0 +1,317 @@
+/*
+ * Bit parallel wavefront flood fill
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include "mazedef.h"
+#include "walkerdef.h"
+#include "search.h"
+#include "solvers.h"
+#include "flood.h"
+#include "timing.h"
+
+/*
+ * The state of a flood.
+ * All bitsets are laid out like the packed grid of the maze, rows are
+ * indexed including the sentinel rows (maze row y is row y + 1).
+ */
+typedef struct flood_t {
+    maze_t *m;
+    const uint64_t *open;
+    /* words per row */
+    long words;
+
+    uint64_t *seen, *front, *next;
+
+    /*
+     * span of words [lo, hi] of the frontier in every row, empty (lo > hi)
+     * for rows without a frontier, and the spans of the next frontier
+     */
+    long *lo, *hi;
+    long *nlo, *nhi;
+    /* the rows with a frontier, and the rows of the next frontier */
+    long *rows, *nrows;
+    long nactive;
+    /* the last wave a row was visited in */
+    long *stamp;
+    /* the number of waves so far */
+    long wave;
+} flood_t;
+
+static void flood_free(flood_t *f) {
+    free(f->seen);
+    free(f->front);
+    free(f->next);
+    free(f->lo);
+    free(f->hi);
+    free(f->nlo);
+    free(f->nhi);
+    free(f->rows);
+    free(f->nrows);
+    free(f->stamp);
+}
+
+/*
+ * Initialises a flood from the tile with index idx
+ */
+static int flood_init(flood_t *f, maze_t *m, long idx) {
+    long rows = m->r + 2;
+    memset(f, 0, sizeof(flood_t));
+    f->m = m;
+    f->open = maze_bits(m);
+    f->words = m->stride / 64;
+    f->seen = calloc(rows * f->words, sizeof(uint64_t));
+    f->front = calloc(rows * f->words, sizeof(uint64_t));
+    f->next = calloc(rows * f->words, sizeof(uint64_t));
+    f->lo = malloc(sizeof(long) * rows);
+    f->hi = malloc(sizeof(long) * rows);
+    f->nlo = malloc(sizeof(long) * rows);
+    f->nhi = malloc(sizeof(long) * rows);
+    f->rows = malloc(sizeof(long) * rows);
+    f->nrows = malloc(sizeof(long) * rows);
+    f->stamp = calloc(rows, sizeof(long));
+    if (!f->open || !f->seen || !f->front || !f->next || !f->lo || !f->hi
+            || !f->nlo || !f->nhi || !f->rows || !f->nrows || !f->stamp) {
+        flood_free(f);
+        return 0;
+    }
+    for (long y = 0; y < rows; y++) {
+        f->lo[y] = f->words;
+        f->hi[y] = -1;
+    }
+
+    long b = idx + m->bbase;
+    bit_set(f->seen, b);
+    bit_set(f->front, b);
+    f->rows[0] = b / m->stride;
+    f->lo[f->rows[0]] = f->hi[f->rows[0]] = (b >> 6) % f->words;
+    f->nactive = 1;
+    return 1;
+}
+
+/*
+ * Computes words [lo, hi] of the next frontier of a row.
+ * fu, fc and fd are the frontier rows above, at and below the row.
+ * The new tiles are stored in nx and added to seen.
+ */
+static void row_wave(uint64_t *nx, const uint64_t *fu, const uint64_t *fc,
+        const uint64_t *fd, const uint64_t *open, uint64_t *seen, long lo,
+        long hi) {
+    long k = lo;
+#if defined(__AVX512F__)
+    for (; k + 7 <= hi; k += 8) {
+        __m512i c = _mm512_loadu_si512(fc + k);
+        __m512i w = _mm512_srli_epi64(_mm512_loadu_si512(fc + k - 1), 63);
+        __m512i e = _mm512_slli_epi64(_mm512_loadu_si512(fc + k + 1), 63);
+        __m512i x = _mm512_or_si512(c, _mm512_slli_epi64(c, 1));
+        x = _mm512_or_si512(x, _mm512_srli_epi64(c, 1));
+        x = _mm512_or_si512(x, _mm512_or_si512(w, e));
+        x = _mm512_or_si512(x, _mm512_loadu_si512(fu + k));
+        x = _mm512_or_si512(x, _mm512_loadu_si512(fd + k));
+        __m512i s = _mm512_loadu_si512(seen + k);
+        x = _mm512_andnot_si512(s, _mm512_and_si512(x,
+                    _mm512_loadu_si512(open + k)));
+        _mm512_storeu_si512(nx + k, x);
+        _mm512_storeu_si512(seen + k, _mm512_or_si512(s, x));
+    }
+#elif defined(__AVX2__)
+    for (; k + 3 <= hi; k += 4) {
+        __m256i c = _mm256_loadu_si256((const __m256i *) (fc + k));
+        __m256i w = _mm256_srli_epi64(
+                _mm256_loadu_si256((const __m256i *) (fc + k - 1)), 63);
+        __m256i e = _mm256_slli_epi64(
+                _mm256_loadu_si256((const __m256i *) (fc + k + 1)), 63);
+        __m256i x = _mm256_or_si256(c, _mm256_slli_epi64(c, 1));
+        x = _mm256_or_si256(x, _mm256_srli_epi64(c, 1));
+        x = _mm256_or_si256(x, _mm256_or_si256(w, e));
+        x = _mm256_or_si256(x, _mm256_loadu_si256((const __m256i *) (fu + k)));
+        x = _mm256_or_si256(x, _mm256_loadu_si256((const __m256i *) (fd + k)));
+        __m256i s = _mm256_loadu_si256((const __m256i *) (seen + k));
+        x = _mm256_andnot_si256(s, _mm256_and_si256(x,
+                    _mm256_loadu_si256((const __m256i *) (open + k))));
+        _mm256_storeu_si256((__m256i *) (nx + k), x);
+        _mm256_storeu_si256((__m256i *) (seen + k), _mm256_or_si256(s, x));
+    }
+#endif
+    for (; k <= hi; k++) {
+        uint64_t x = fc[k] | fc[k] << 1 | fc[k - 1] >> 63 | fc[k] >> 1
+            | fc[k + 1] << 63 | fu[k] | fd[k];
+        x &= open[k] & ~seen[k];
+        nx[k] = x;
+        seen[k] |= x;
+    }
+}
+
+/*
+ * Expands the frontier by one wave.
+ * When dist3 is not NULL the wave number modulo 3 is stored for every
+ * new tile, indexed by bit position.
+ *
+ * returns the number of rows in the new frontier
+ */
+static long flood_wave(flood_t *f, uint8_t *dist3) {
+    long words = f->words;
+    long last = f->m->r;
+    long nvisit = 0;
+    f->wave++;
+
+    for (long i = 0; i < f->nactive; i++) {
+        for (long y = f->rows[i] - 1; y <= f->rows[i] + 1; y++) {
+            /* rows 0 and r + 1 are the sentinel rows */
+            if (y < 1 || y > last || f->stamp[y] == f->wave)
+                continue;
+            f->stamp[y] = f->wave;
+
+            /* the words that can be reached from the frontier */
+            long lo = words, hi = -1;
+            for (long n = y - 1; n <= y + 1; n++) {
+                if (f->lo[n] > f->hi[n])
+                    continue;
+                if (f->lo[n] - 1 < lo)
+                    lo = f->lo[n] - 1;
+                if (f->hi[n] + 1 > hi)
+                    hi = f->hi[n] + 1;
+            }
+            if (lo < 0)
+                lo = 0;
+            if (hi > words - 1)
+                hi = words - 1;
+
+            long row = y * words;
+            row_wave(f->next + row, f->front + row - words, f->front + row,
+                    f->front + row + words, f->open + row, f->seen + row,
+                    lo, hi);
+
+            /* find the span of the new frontier of the row */
+            long nlo = words, nhi = -1;
+            for (long k = lo; k <= hi; k++) {
+                uint64_t x = f->next[row + k];
+                if (!x)
+                    continue;
+                if (k < nlo)
+                    nlo = k;
+                nhi = k;
+                if (dist3) {
+                    for (; x; x &= x - 1)
+                        set_dir2(dist3, ((row + k) << 6) + __builtin_ctzll(x),
+                                f->wave % 3);
+                }
+            }
+            f->nrows[nvisit++] = y;
+            f->nlo[y] = nlo;
+            f->nhi[y] = nhi;
+        }
+    }
+
+    /* clear the old frontier, so it can hold the next wave */
+    for (long i = 0; i < f->nactive; i++) {
+        long y = f->rows[i];
+        memset(f->front + y * words + f->lo[y], 0,
+                sizeof(uint64_t) * (f->hi[y] - f->lo[y] + 1));
+        f->lo[y] = words;
+        f->hi[y] = -1;
+    }
+    uint64_t *t = f->front;
+    f->front = f->next;
+    f->next = t;
+
+    /* only keep the rows with a frontier */
+    long n = 0;
+    for (long i = 0; i < nvisit; i++) {
+        long y = f->nrows[i];
+        if (f->nlo[y] > f->nhi[y])
+            continue;
+        f->lo[y] = f->nlo[y];
+        f->hi[y] = f->nhi[y];
+        f->rows[n++] = y;
+    }
+    f->nactive = n;
+    return n;
+}
+
+int flood_reachable(maze_t *m, point_t a, point_t b) {
+    flood_t f;
+    if (!flood_init(&f, m, maze_idx(m, a)))
+        return -1;
+
+    long target = maze_idx(m, b) + m->bbase;
+    int found = bit_test(f.seen, target);
+    while (!found && flood_wave(&f, NULL))
+        found = bit_test(f.seen, target);
+
+    flood_free(&f);
+    return found;
+}
+
+int init_flood(maze_t *m, walker_t *w) {
+    if (w->state != NULL)
+        return 0;
+
+    double t = now_sec();
+    int status = INIT_FAILED;
+    flood_t f;
+    if (!flood_init(&f, m, maze_idx(m, m->exit)))
+        return 0;
+
+    long words = (m->r + 2) * f.words;
+    uint8_t *dist3 = calloc(words * 16, 1);
+    path_t *p = malloc(sizeof(path_t));
+    if (p)
+        p->moves = NULL;
+    if (!dist3 || !p)
+        goto fail;
+
+    long from = maze_idx(m, m->start) + m->bbase;
+    while (!bit_test(f.seen, from) && flood_wave(&f, dist3))
+        ;
+    if (!bit_test(f.seen, from)) {
+        fprintf(stderr, "flood: the exit can not be reached from the start\n");
+        status = INIT_UNREACHABLE;
+        goto fail;
+    }
+
+    /* the start is wave number len, walk down the distances */
+    long len = f.wave;
+    p->moves = calloc((len + 3) / 4 + 1, 1);
+    if (!p->moves)
+        goto fail;
+    p->len = len;
+    p->next = 0;
+    p->expanded = 0;
+    for (long k = 0; k < words; k++)
+        p->expanded += __builtin_popcountll(f.seen[k]);
+
+    long b = from;
+    for (long i = 0; i < len; i++) {
+        int d = (len - i - 1) % 3;
+        int mask = maze_open_mask(m, b - m->bbase);
+        for (int dir = 0; dir < 4; dir++) {
+            long n = b + m->off[dir];
+            if (((mask >> dir) & 1) && bit_test(f.seen, n)
+                    && (int) get_dir2(dist3, n) == d) {
+                set_dir2(p->moves, i, dir);
+                b = n;
+                break;
+            }
+        }
+    }
+    p->time = now_sec() - t;
+    w->state = p;
+
+    free(dist3);
+    flood_free(&f);
+    return 1;
+
+fail:
+    if (p)
+        free(p->moves);
+    free(p);
+    free(dist3);
+    flood_free(&f);
+    return status;
+}
@@ -0,0 +1,34 @@
+/*
+ * Bit parallel wavefront flood fill
+ *
+ * Floods the packed grid a word (64 tiles) at a time, or 4 or 8 words at
+ * a time when built with AVX2 or AVX-512 support (e.g. ARCH=-march=native).
+ * Every wave expands the frontier with shifts and ors of the rows above,
+ * at and below a tile, masked with the open tiles. Only the words around
+ * the previous frontier are visited, so a wave costs time proportional to
+ * the size of the frontier rather than to the size of the maze.
+ */
+
+#ifndef FLOOD_H
+#define FLOOD_H
+
+#include "point.h"
+#include "maze.h"
+
+/*
+ * Checks whether tile b can be reached from tile a
+ *
+ * returns 1 if b can be reached
+ * returns 0 if it can not be reached
+ * returns -1 when out of memory
+ */
+int flood_reachable(maze_t *m, point_t a, point_t b);
+
+/*
+ * Flood solver, floods from the exit until the start is reached and then
+ * walks down the distances. The distances are stored modulo 3, 2 bits
+ * per tile, which is enough to tell the next tile of the path apart.
+ */
+int init_flood(maze_t *m, walker_t *w);
+
+#endif /* FLOOD_H */
@@ -0,0 +1,157 @@
+/*
+ * Render thread
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+#include "mazedef.h"
+#include "walkerdef.h"
+#include "renderer.h"
+#include "frames.h"
+#include "timing.h"
+
+struct frames_t {
+    maze_t *m;
+    pthread_t tid;
+    /* the time between two frames in seconds */
+    double period;
+
+    /* set by stop_frames() */
+    int stop;
+    /* 1 = the render thread waits for a frame, 0 = a frame is published */
+    int want;
+    /* the buffer that holds the published frame */
+    int front;
+
+    /* per buffer: the tile index of the walker, -1 when not shown */
+    long idx[2];
+    /* per buffer: the occupancy overlay, NULL when not shown */
+    uint32_t *occ[2];
+
+    /* the walker drawn by the renderer, the view port follows it */
+    walker_t shown;
+
+    /* the frame statistics, see report_frames() */
+    long wakes, frames, late;
+    double lag_sum, lag_sq, lag_max;
+};
+
+static void draw(frames_t *f, int b) {
+    int err;
+    walker_t *w = NULL;
+    if (f->idx[b] >= 0) {
+        place_walker(f->m, &f->shown, f->idx[b]);
+        w = &f->shown;
+    } else if (!f->occ[b]) {
+        /* nothing was published yet */
+        return;
+    }
+    rs_set_occupancy(f->occ[b]);
+    if ((err = render_maze(f->m, w)) != MRSUCC)
+        mrerror("Error while rendering", err);
+}
+
+static void* frame_thread(void *arg) {
+    frames_t *f = arg;
+    double deadline = now_sec();
+    while (!__atomic_load_n(&f->stop, __ATOMIC_RELAXED)) {
+        deadline += f->period;
+        sleep_until(deadline);
+
+        double lag = now_sec() - deadline;
+        if (lag < 0)
+            lag = 0;
+        f->wakes++;
+        f->lag_sum += lag;
+        f->lag_sq += lag * lag;
+        if (lag > f->lag_max)
+            f->lag_max = lag;
+        /* a frame that took longer than a period drops the frames it
+         * overran instead of drawing them all in a burst */
+        if (lag > f->period) {
+            f->late++;
+            deadline = now_sec();
+        }
+
+        if (__atomic_load_n(&f->want, __ATOMIC_ACQUIRE))
+            continue;
+        draw(f, __atomic_load_n(&f->front, __ATOMIC_RELAXED));
+        f->frames++;
+        __atomic_store_n(&f->want, 1, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+frames_t* start_frames(maze_t *m, int fps, point_t focus) {
+    frames_t *f = calloc(1, sizeof(frames_t));
+    if (!f)
+        return NULL;
+    f->m = m;
+    f->period = 1.0 / fps;
+    f->want = 1;
+    f->idx[0] = f->idx[1] = -1;
+    f->shown.pos = focus;
+    f->shown.idx = maze_idx(m, focus);
+    rs_set_focus(&f->shown.pos);
+
+    if (pthread_create(&f->tid, NULL, frame_thread, f)) {
+        free(f);
+        return NULL;
+    }
+    return f;
+}
+
+int frame_wanted(frames_t *f) {
+    return __atomic_load_n(&f->want, __ATOMIC_ACQUIRE);
+}
+
+void frame_walker(frames_t *f, long idx) {
+    f->idx[!f->front] = idx;
+    frame_publish(f);
+}
+
+uint32_t* frame_occupancy(frames_t *f) {
+    int b = !f->front;
+    size_t size = (size_t) f->m->r * f->m->stride;
+    if (!f->occ[b])
+        f->occ[b] = malloc(sizeof(uint32_t) * size);
+    return f->occ[b];
+}
+
+void frame_publish(frames_t *f) {
+    __atomic_store_n(&f->front, !f->front, __ATOMIC_RELAXED);
+    __atomic_store_n(&f->want, 0, __ATOMIC_RELEASE);
+}
+
+void stop_frames(frames_t *f) {
+    __atomic_store_n(&f->stop, 1, __ATOMIC_RELAXED);
+    pthread_join(f->tid, NULL);
+}
+
+void draw_frame(frames_t *f) {
+    draw(f, f->front);
+    f->frames++;
+}
+
+void report_frames(frames_t *f) {
+    double mean = 0, sd = 0;
+    if (f->wakes) {
+        mean = f->lag_sum / f->wakes;
+        sd = sqrt(fmax(f->lag_sq / f->wakes - mean * mean, 0));
+    }
+    fprintf(stderr, "drew %ld frames at %.0f fps, woke up %.3f ms late on "
+            "average (sd %.3f ms, max %.3f ms), %ld deadlines missed\n",
+            f->frames, 1.0 / f->period, mean * 1e3, sd * 1e3,
+            f->lag_max * 1e3, f->late);
+}
+
+void cleanup_frames(frames_t *f) {
+    if (!f)
+        return;
+    rs_set_occupancy(NULL);
+    free(f->occ[0]);
+    free(f->occ[1]);
+    free(f);
+}
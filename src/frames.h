@@ -0,0 +1,81 @@
+/*
+ * Render thread
+ *
+ * Draws the progress of a run at a fixed frame rate on a thread of its
+ * own, so the simulation runs at full speed no matter how slow the
+ * terminal is. The render thread wakes at absolute deadlines and asks
+ * the simulation for a frame, the simulation hands over a snapshot of
+ * the walker or of the swarm between two steps.
+ *
+ * The snapshots are double buffered: the simulation only writes the back
+ * buffer while the render thread waits for a frame, and publishing a
+ * frame swaps the buffers. Neither side ever waits for the other.
+ */
+
+#ifndef FRAMES_H
+#define FRAMES_H
+
+#include <stdint.h>
+#include "point.h"
+#include "maze.h"
+
+typedef struct frames_t frames_t;
+
+/*
+ * Starts a render thread that draws m fps times per second.
+ * focus is where the view port looks until the first walker is handed
+ * over, see frame_walker().
+ *
+ * returns the render thread on success
+ * returns NULL on failure
+ */
+frames_t* start_frames(maze_t *m, int fps, point_t focus);
+
+/*
+ * Returns 1 when the render thread waits for a new frame, cheap enough
+ * to be called after every step
+ */
+int frame_wanted(frames_t *f);
+
+/*
+ * Publishes a frame that shows the walker on tile index idx
+ */
+void frame_walker(frames_t *f, long idx);
+
+/*
+ * Returns the back buffer of the occupancy overlay, indexed like the
+ * cells of the maze, to be filled and published with frame_publish()
+ *
+ * returns NULL when out of memory
+ */
+uint32_t* frame_occupancy(frames_t *f);
+
+/*
+ * Publishes the frame in the back buffer
+ */
+void frame_publish(frames_t *f);
+
+/*
+ * Stops the render thread. The caller owns both buffers afterwards, so
+ * the final state can be published and drawn with draw_frame().
+ */
+void stop_frames(frames_t *f);
+
+/*
+ * Draws the last published frame on the calling thread.
+ * Only to be called after stop_frames()
+ */
+void draw_frame(frames_t *f);
+
+/*
+ * Prints how many frames were drawn and how late the render thread woke
+ * up for them
+ */
+void report_frames(frames_t *f);
+
+/*
+ * Frees a render thread stopped by stop_frames()
+ */
+void cleanup_frames(frames_t *f);
+
+#endif /* FRAMES_H */
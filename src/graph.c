@@ -0,0 +1,481 @@
+/*
+ * Junction graph of a maze and the solvers that run on it
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "mazedef.h"
+#include "walkerdef.h"
+#include "graph.h"
+#include "search.h"
+#include "queue.h"
+#include "timing.h"
+#include "solvers.h"
+#include "kernels.h"
+
+/* marks a tile that is not a node */
+#define NO_NODE UINT32_MAX
+
+/*
+ * The state of a graph solver
+ */
+typedef struct graph_walk_t {
+    graph_t *g;
+
+    /*
+     * the edges to follow, found by a search,
+     * NULL when the edges are chosen while walking
+     */
+    long *route;
+    long nroute;
+    /* index of the next edge of route */
+    long next;
+
+    /* the edge being followed, -1 when standing on node */
+    long edge;
+    /* the next move of edge */
+    long step;
+    long node;
+    /* the last move */
+    direction_t dir;
+    /* detects the wall follower walking in a circle */
+    cycle_t cycle;
+
+    /* number of moves of the route */
+    long len;
+    /* number of nodes the search expanded */
+    long expanded;
+    /* the time building the graph and searching it took in seconds */
+    double build, time;
+} graph_walk_t;
+
+/*
+ * Appends dir to the moves of g, growing them when needed
+ *
+ * returns 0 when out of memory
+ */
+static int push_move(graph_t *g, long *cap, direction_t dir) {
+    if (g->nmoves == *cap * 4) {
+        uint8_t *moves = realloc(g->moves, *cap * 2);
+        if (!moves)
+            return 0;
+        memset(moves + *cap, 0, *cap);
+        g->moves = moves;
+        *cap *= 2;
+    }
+    set_dir2(g->moves, g->nmoves++, dir);
+    return 1;
+}
+
+void free_graph(graph_t *g) {
+    if (!g)
+        return;
+    free(g->node);
+    free(g->first);
+    free(g->target);
+    free(g->len);
+    free(g->at);
+    free(g->moves);
+    free(g);
+}
+
+graph_t* build_graph(maze_t *m) {
+    long size = search_size(m);
+    long start = maze_idx(m, m->start), exit = maze_idx(m, m->exit);
+    long cap = 1024;
+
+    graph_t *g = calloc(1, sizeof(graph_t));
+    uint32_t *id = malloc(sizeof(uint32_t) * size);
+    if (!g || !id)
+        goto fail;
+
+    /* number the nodes and count their edges */
+    long nnodes = 0, nedges = 0;
+    for (int y = 0; y < m->r; y++) {
+        for (int x = 0; x < m->c; x++) {
+            long idx = maze_idx(m, (point_t) {x, y});
+            id[idx] = NO_NODE;
+            if (!maze_open(m, idx))
+                continue;
+            int deg = __builtin_popcount(maze_open_mask(m, idx));
+            if (deg == 2 && idx != start && idx != exit)
+                continue;
+            id[idx] = nnodes++;
+            nedges += deg;
+        }
+    }
+
+    g->nnodes = nnodes;
+    g->nedges = nedges;
+    g->node = malloc(sizeof(long) * (nnodes + 1));
+    g->first = malloc(sizeof(long) * (nnodes + 1));
+    g->target = malloc(sizeof(long) * (nedges + 1));
+    g->len = malloc(sizeof(long) * (nedges + 1));
+    g->at = malloc(sizeof(long) * (nedges + 1));
+    g->moves = calloc(cap, 1);
+    if (!g->node || !g->first || !g->target || !g->len || !g->at
+            || !g->moves)
+        goto fail;
+
+    /* follow every corridor leaving a node until the next node */
+    long n = 0, e = 0;
+    for (int y = 0; y < m->r; y++) {
+        for (int x = 0; x < m->c; x++) {
+            long idx = maze_idx(m, (point_t) {x, y});
+            if (id[idx] == NO_NODE)
+                continue;
+            g->node[n] = idx;
+            g->first[n++] = e;
+
+            int mask = maze_open_mask(m, idx);
+            for (int dir = 0; dir < 4; dir++) {
+                if (!((mask >> dir) & 1))
+                    continue;
+                g->at[e] = g->nmoves;
+                direction_t d = dir;
+                long cur = idx + m->off[d];
+                if (!push_move(g, &cap, d))
+                    goto fail;
+                while (id[cur] == NO_NODE) {
+                    /* a corridor tile has one way out besides the way in */
+                    d = __builtin_ctz(maze_open_mask(m, cur) & ~(1 << (d ^ 2)));
+                    cur += m->off[d];
+                    if (!push_move(g, &cap, d))
+                        goto fail;
+                }
+                g->target[e] = id[cur];
+                g->len[e] = g->nmoves - g->at[e];
+                e++;
+            }
+        }
+    }
+    g->first[n] = e;
+    g->start = id[start];
+    g->exit = id[exit];
+
+    free(id);
+    return g;
+
+fail:
+    free(id);
+    free_graph(g);
+    return NULL;
+}
+
+/*
+ * Returns the edge leaving node n whose first move is dir,
+ * -1 if there is none
+ */
+static long edge_dir(const graph_t *g, long n, direction_t dir) {
+    for (long e = g->first[n]; e < g->first[n + 1]; e++)
+        if (get_dir2(g->moves, g->at[e]) == dir)
+            return e;
+    return -1;
+}
+
+/*
+ * Returns the next edge to follow from the current node,
+ * -1 if there is none and -2 if the wall follower walks in a circle
+ */
+static long next_edge(graph_walk_t *s) {
+    if (s->route)
+        return s->next < s->nroute ? s->route[s->next++] : -1;
+
+    /* wall follower, go right by default and rotate left from there */
+    if (s->g->first[s->node] == s->g->first[s->node + 1])
+        return -1;
+    if (cycle_step(&s->cycle, s->node, s->dir))
+        return -2;
+    direction_t cd = rotate_dir(s->dir, RIGHT, 1);
+    long e;
+    while ((e = edge_dir(s->g, s->node, cd)) < 0)
+        cd = rotate_dir(cd, LEFT, 1);
+    return e;
+}
+
+direction_t graph_walker(maze_t *m, walker_t *w) {
+    (void) m;
+    graph_walk_t *s = w->state;
+    graph_t *g = s->g;
+
+    if (s->edge < 0 || s->step == g->len[s->edge]) {
+        if (s->edge >= 0)
+            s->node = g->target[s->edge];
+        s->edge = next_edge(s);
+        s->step = 0;
+        if (s->edge == -2)
+            return DIR_HALT;
+        if (s->edge < 0)
+            return -1;
+    }
+    s->dir = get_dir2(g->moves, g->at[s->edge] + s->step++);
+    return s->dir;
+}
+
+int graph_run(maze_t *m, walker_t *w, long max_steps, long *steps) {
+    graph_walk_t *s = w->state;
+    graph_t *g = s->g;
+    long idx = w->idx, exit = maze_idx(m, m->exit);
+    int status = RUN_BUDGET;
+    long n = 0;
+
+    while (n < max_steps) {
+        if (s->edge < 0 || s->step == g->len[s->edge]) {
+            if (s->edge >= 0)
+                s->node = g->target[s->edge];
+            s->edge = next_edge(s);
+            s->step = 0;
+            if (s->edge == -2) {
+                status = RUN_HALT;
+                break;
+            }
+            if (s->edge < 0) {
+                /* nowhere to go, every step stays in place */
+                n = max_steps;
+                break;
+            }
+        }
+
+        long e = s->edge;
+        long left = g->len[e] - s->step;
+        if (left <= max_steps - n) {
+            /* jump to the end of the corridor */
+            n += left;
+            s->step = g->len[e];
+            s->dir = get_dir2(g->moves, g->at[e] + s->step - 1);
+            idx = g->node[g->target[e]];
+        } else {
+            /* out of steps halfway, the exit is never inside a corridor */
+            for (; n < max_steps; n++) {
+                s->dir = get_dir2(g->moves, g->at[e] + s->step++);
+                idx += m->off[s->dir];
+            }
+        }
+        if (idx == exit) {
+            status = RUN_EXIT;
+            break;
+        }
+    }
+
+    place_walker(m, w, idx);
+    *steps = n;
+    return status;
+}
+
+void free_graph_walk(void *state) {
+    graph_walk_t *s = state;
+    if (!s)
+        return;
+    free_graph(s->g);
+    free(s->route);
+    free(s);
+}
+
+void report_graph(void *state) {
+    graph_walk_t *s = state;
+    printf("Graph of %ld nodes and %ld corridors, %ld moves, "
+            "built in %.3f ms\n", s->g->nnodes, s->g->nedges / 2,
+            s->g->nmoves / 2, s->build * 1e3);
+    if (s->route)
+        printf("Path length %ld over %ld corridors, %ld nodes expanded, "
+                "search took %.3f ms\n", s->len, s->nroute, s->expanded,
+                s->time * 1e3);
+}
+
+/*
+ * Builds the graph of m and stores a new graph solver state in w
+ *
+ * returns the state on success
+ * returns NULL when out of memory
+ */
+static graph_walk_t* graph_walk_init(maze_t *m, walker_t *w) {
+    if (w->state != NULL)
+        return NULL;
+    graph_walk_t *s = calloc(1, sizeof(graph_walk_t));
+    if (!s)
+        return NULL;
+
+    double t = now_sec();
+    s->g = build_graph(m);
+    s->build = now_sec() - t;
+    if (!s->g) {
+        free(s);
+        return NULL;
+    }
+    s->edge = -1;
+    s->node = s->g->start;
+    s->dir = NORTH;
+    cycle_init(&s->cycle);
+    w->state = s;
+    return s;
+}
+
+/*
+ * Stores the route to the exit, found by following the parent edges of
+ * the nodes back from the exit, in s
+ *
+ * returns 0 when out of memory
+ */
+static int trace_route(graph_walk_t *s, const long *pedge,
+        const long *pnode) {
+    graph_t *g = s->g;
+    long n = 0;
+    for (long v = g->exit; v != g->start; v = pnode[v])
+        n++;
+
+    s->route = malloc(sizeof(long) * (n + 1));
+    if (!s->route)
+        return 0;
+    s->nroute = n;
+    s->len = 0;
+    for (long v = g->exit; v != g->start; v = pnode[v]) {
+        s->route[--n] = pedge[v];
+        s->len += g->len[pedge[v]];
+    }
+    return 1;
+}
+
+int init_graph_bfs(maze_t *m, walker_t *w) {
+    graph_walk_t *s = graph_walk_init(m, w);
+    if (!s)
+        return 0;
+
+    double t = now_sec();
+    int status = INIT_FAILED;
+    graph_t *g = s->g;
+    long *pedge = malloc(sizeof(long) * g->nnodes);
+    long *pnode = malloc(sizeof(long) * g->nnodes);
+    queue_t q;
+    q.buf = NULL;
+    int found = g->start == g->exit;
+    if (!pedge || !pnode || !queue_init(&q))
+        goto fail;
+
+    for (long i = 0; i < g->nnodes; i++)
+        pnode[i] = -1;
+    pnode[g->start] = g->start;
+    if (!queue_push(&q, g->start))
+        goto fail;
+
+    while (q.len && !found) {
+        long u = queue_pop(&q);
+        s->expanded++;
+        for (long e = g->first[u]; e < g->first[u + 1]; e++) {
+            long v = g->target[e];
+            if (pnode[v] >= 0)
+                continue;
+            pnode[v] = u;
+            pedge[v] = e;
+            if (v == g->exit) {
+                found = 1;
+                break;
+            }
+            if (!queue_push(&q, v))
+                goto fail;
+        }
+    }
+
+    if (!found) {
+        fprintf(stderr, "graphbfs: the exit can not be reached from the "
+                "start\n");
+        status = INIT_UNREACHABLE;
+        goto fail;
+    }
+    if (!trace_route(s, pedge, pnode))
+        goto fail;
+    s->time = now_sec() - t;
+
+    free(q.buf);
+    free(pedge);
+    free(pnode);
+    return 1;
+
+fail:
+    free(q.buf);
+    free(pedge);
+    free(pnode);
+    return status;
+}
+
+int init_graph_dijkstra(maze_t *m, walker_t *w) {
+    graph_walk_t *s = graph_walk_init(m, w);
+    if (!s)
+        return 0;
+
+    double t = now_sec();
+    int status = INIT_FAILED;
+    graph_t *g = s->g;
+    long *pedge = malloc(sizeof(long) * g->nnodes);
+    long *pnode = malloc(sizeof(long) * g->nnodes);
+    long *dist = malloc(sizeof(long) * g->nnodes);
+    int found = 0;
+
+    /* the keys in the queue lie within a corridor of the smallest key */
+    long span = 1;
+    for (long e = 0; e < g->nedges; e++)
+        if (g->len[e] > span)
+            span = g->len[e];
+    bucket_queue_t q;
+    memset(&q, 0, sizeof(q));
+    if (!pedge || !pnode || !dist || !bq_init(&q, span))
+        goto fail;
+
+    for (long i = 0; i < g->nnodes; i++)
+        dist[i] = -1;
+    dist[g->start] = 0;
+    pnode[g->start] = g->start;
+    if (!bq_push(&q, 0, g->start))
+        goto fail;
+
+    while (q.size) {
+        long d;
+        long u = bq_pop(&q, &d);
+        /* skip the entries of nodes that were reached faster since */
+        if (d > dist[u])
+            continue;
+        s->expanded++;
+        if (u == g->exit) {
+            found = 1;
+            break;
+        }
+        for (long e = g->first[u]; e < g->first[u + 1]; e++) {
+            long v = g->target[e];
+            long nd = d + g->len[e];
+            if (dist[v] >= 0 && dist[v] <= nd)
+                continue;
+            dist[v] = nd;
+            pnode[v] = u;
+            pedge[v] = e;
+            if (!bq_push(&q, nd, v))
+                goto fail;
+        }
+    }
+
+    if (!found) {
+        fprintf(stderr, "graphdijkstra: the exit can not be reached from "
+                "the start\n");
+        status = INIT_UNREACHABLE;
+        goto fail;
+    }
+    if (!trace_route(s, pedge, pnode))
+        goto fail;
+    s->time = now_sec() - t;
+
+    bq_free(&q);
+    free(pedge);
+    free(pnode);
+    free(dist);
+    return 1;
+
+fail:
+    bq_free(&q);
+    free(pedge);
+    free(pnode);
+    free(dist);
+    return status;
+}
+
+int init_graph_wall(maze_t *m, walker_t *w) {
+    return graph_walk_init(m, w) != NULL;
+}
@@ -0,0 +1,103 @@
+/*
+ * Junction graph of a maze
+ *
+ * The corridors of a maze are contracted into the edges of a graph. The
+ * nodes are the junctions, the dead ends, the start and the exit, every
+ * other open tile lies on exactly one corridor between two nodes.
+ * The graph solvers decide once per corridor instead of once per tile,
+ * the walker expands the corridors back into single moves.
+ */
+
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <stdint.h>
+#include "point.h"
+#include "maze.h"
+
+/*
+ * A junction graph in compressed sparse row form.
+ * Every corridor is stored as two edges, one for each direction.
+ */
+typedef struct graph_t {
+    long nnodes, nedges;
+
+    /* the tile index of every node */
+    long *node;
+
+    /*
+     * the edges leaving node n are [first[n], first[n + 1]),
+     * ordered by the direction of their first move
+     */
+    long *first;
+
+    /* the node an edge leads to */
+    long *target;
+    /* the number of moves of an edge */
+    long *len;
+    /* the index of the first move of an edge in moves */
+    long *at;
+
+    /* the moves of all edges, 2 bits per move */
+    uint8_t *moves;
+    long nmoves;
+
+    /* the nodes of the start and the exit */
+    long start, exit;
+} graph_t;
+
+/*
+ * Builds the junction graph of m
+ *
+ * returns the graph on success
+ * returns NULL when out of memory
+ */
+graph_t* build_graph(maze_t *m);
+
+/*
+ * Frees a graph made by build_graph()
+ */
+void free_graph(graph_t *g);
+
+/*
+ * Solver function shared by the graph solvers, follows the edges chosen
+ * by the solver one move per step.
+ * Returns -1 when there is no edge left to follow
+ */
+direction_t graph_walker(maze_t *m, walker_t *w);
+
+/*
+ * Run function shared by the graph solvers, see algorithm_t.
+ * Jumps over whole corridors instead of taking their moves one by one.
+ */
+int graph_run(maze_t *m, walker_t *w, long max_steps, long *steps);
+
+/*
+ * Frees the state of a graph solver
+ */
+void free_graph_walk(void *state);
+
+/*
+ * Prints the size of the graph and the statistics of the search
+ */
+void report_graph(void *state);
+
+/*
+ * Breadth first search over the graph for the path with the fewest
+ * corridors
+ */
+int init_graph_bfs(maze_t *m, walker_t *w);
+
+/*
+ * Dijkstra's algorithm over the graph for the shortest path, weighing
+ * the corridors by their length
+ */
+int init_graph_dijkstra(maze_t *m, walker_t *w);
+
+/*
+ * Wall follower that keeps a wall on its right hand, choosing the next
+ * corridor at every node. Takes the same steps as wallfollower.
+ */
+int init_graph_wall(maze_t *m, walker_t *w);
+
+#endif /* GRAPH_H */
@@ -0,0 +1,295 @@
+/*
+ * Image export
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "mazedef.h"
+#include "image.h"
+
+enum { FMT_PPM, FMT_PGM, FMT_PNG };
+
+/* the longest stored deflate block */
+#define STORED_MAX 65535
+/* the most bytes adler32 can add up before the sums have to be reduced */
+#define ADLER_NMAX 5552
+#define ADLER_MOD 65521
+
+/* the colours of the picture */
+static const uint8_t col_start[3] = {0, 160, 0};
+static const uint8_t col_exit[3] = {255, 0, 0};
+static const uint8_t col_walker[3] = {0, 64, 255};
+/* the heat ramp runs from cold to hot */
+static const uint8_t col_cold[3] = {255, 224, 0};
+static const uint8_t col_hot[3] = {230, 90, 0};
+
+/* the movement of a tile in every direction, see direction_t */
+static const int dir_dx[4] = {0, 1, 0, -1};
+static const int dir_dy[4] = {-1, 0, 1, 0};
+
+typedef struct image_out_t {
+    FILE *f;
+    int format;
+    long w, h;
+    /* the bytes per row, including the filter byte of a PNG */
+    size_t row_len;
+    /* the row that is composed */
+    uint8_t *row;
+
+    /* the checksums of a PNG, over the chunk and the zlib stream */
+    uint32_t crc, adler_a, adler_b;
+} image_out_t;
+
+static uint32_t crc_table[256];
+
+static void init_crc(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+            c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+        crc_table[n] = c;
+    }
+}
+
+/* writes len bytes of a PNG chunk and adds them to the crc */
+static void chunk_put(image_out_t *o, const uint8_t *p, size_t len) {
+    uint32_t c = o->crc;
+    for (size_t i = 0; i < len; i++)
+        c = crc_table[(c ^ p[i]) & 0xff] ^ (c >> 8);
+    o->crc = c;
+    fwrite(p, 1, len, o->f);
+}
+
+/* writes a big endian number in a PNG chunk */
+static void chunk_put32(image_out_t *o, uint32_t v) {
+    uint8_t b[4] = {v >> 24, v >> 16, v >> 8, v};
+    chunk_put(o, b, 4);
+}
+
+/* starts a PNG chunk of len bytes */
+static void chunk_start(image_out_t *o, const char *type, uint32_t len) {
+    uint8_t b[4] = {len >> 24, len >> 16, len >> 8, len};
+    fwrite(b, 1, 4, o->f);
+    o->crc = 0xffffffff;
+    chunk_put(o, (const uint8_t *) type, 4);
+}
+
+static void chunk_end(image_out_t *o) {
+    uint32_t c = ~o->crc;
+    uint8_t b[4] = {c >> 24, c >> 16, c >> 8, c};
+    fwrite(b, 1, 4, o->f);
+}
+
+static void adler(image_out_t *o, const uint8_t *p, size_t len) {
+    while (len) {
+        size_t n = len < ADLER_NMAX ? len : ADLER_NMAX;
+        len -= n;
+        while (n--) {
+            o->adler_a += *p++;
+            o->adler_b += o->adler_a;
+        }
+        o->adler_a %= ADLER_MOD;
+        o->adler_b %= ADLER_MOD;
+    }
+}
+
+static void write_header(image_out_t *o) {
+    if (o->format == FMT_PNG) {
+        static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n',
+            0x1a, '\n'};
+        fwrite(sig, 1, 8, o->f);
+        chunk_start(o, "IHDR", 13);
+        chunk_put32(o, o->w);
+        chunk_put32(o, o->h);
+        /* 8 bit RGB, deflate, no filters, not interlaced */
+        static const uint8_t ihdr[5] = {8, 2, 0, 0, 0};
+        chunk_put(o, ihdr, 5);
+        chunk_end(o);
+        o->adler_a = 1;
+        o->adler_b = 0;
+    } else {
+        fprintf(o->f, "P%c\n%ld %ld\n255\n", o->format == FMT_PGM ? '5' : '6',
+                o->w, o->h);
+    }
+}
+
+/*
+ * writes the composed row. A PNG gets a chunk per row that holds the row
+ * as stored deflate blocks, the zlib stream runs over all chunks.
+ */
+static void write_row(image_out_t *o, int first) {
+    if (o->format != FMT_PNG) {
+        fwrite(o->row, 1, o->row_len, o->f);
+        return;
+    }
+    size_t blocks = (o->row_len + STORED_MAX - 1) / STORED_MAX;
+    chunk_start(o, "IDAT", (first ? 2 : 0) + blocks * 5 + o->row_len);
+    if (first) {
+        /* zlib header: deflate with a 32K window, no dictionary */
+        static const uint8_t zlib[2] = {0x78, 0x01};
+        chunk_put(o, zlib, 2);
+    }
+    for (size_t at = 0; at < o->row_len; at += STORED_MAX) {
+        size_t n = o->row_len - at < STORED_MAX ? o->row_len - at : STORED_MAX;
+        uint8_t b[5] = {0, n, n >> 8, ~n, ~n >> 8};
+        chunk_put(o, b, 5);
+        chunk_put(o, o->row + at, n);
+    }
+    adler(o, o->row, o->row_len);
+    chunk_end(o);
+}
+
+static void write_trailer(image_out_t *o) {
+    if (o->format != FMT_PNG)
+        return;
+    /* an empty final block ends the deflate stream */
+    static const uint8_t last[5] = {1, 0, 0, 0xff, 0xff};
+    chunk_start(o, "IDAT", 9);
+    chunk_put(o, last, 5);
+    chunk_put32(o, o->adler_b << 16 | o->adler_a);
+    chunk_end(o);
+    chunk_start(o, "IEND", 0);
+    chunk_end(o);
+}
+
+static int image_format(const char *fname) {
+    const char *ext = strrchr(fname, '.');
+    if (ext && !strcmp(ext, ".pgm"))
+        return FMT_PGM;
+    if (ext && !strcmp(ext, ".png"))
+        return FMT_PNG;
+    return FMT_PPM;
+}
+
+/* the colour of a block of tiles that are not marked */
+static void block_colour(uint8_t *rgb, long walls, long tiles, uint32_t visits) {
+    if (!visits) {
+        uint8_t g = 255 - walls * 255 / tiles;
+        rgb[0] = rgb[1] = rgb[2] = g;
+        return;
+    }
+    long open = tiles - walls;
+    double heat = log2((double) visits / (open ? open : 1))
+        / log2(IMAGE_HEAT_MAX);
+    if (heat < 0)
+        heat = 0;
+    if (heat > 1)
+        heat = 1;
+    for (int i = 0; i < 3; i++)
+        rgb[i] = col_cold[i] + (col_hot[i] - col_cold[i]) * heat;
+}
+
+/*
+ * counts the visits of the first steps of t to the blocks in rows
+ * [b0, b1) of the picture, counts holds a row of w blocks per row
+ */
+static void count_visits(maze_t *m, trace_t *t, long steps, int scale,
+        long b0, long b1, long w, uint32_t *counts) {
+    trace_cursor_t c;
+    trace_seek(t, &c, 0);
+    long x = c.idx % m->stride, y = c.idx / m->stride;
+    for (;;) {
+        long by = y / scale;
+        if (by >= b0 && by < b1) {
+            uint32_t *n = counts + (by - b0) * w + x / scale;
+            if (*n != UINT32_MAX)
+                (*n)++;
+        }
+        if (c.step >= steps || !trace_next(t, &c))
+            break;
+        if (c.kind != TK_STAY) {
+            x += dir_dx[c.dir];
+            y += dir_dy[c.dir];
+        }
+    }
+}
+
+int write_image(const char *fname, maze_t *m, trace_t *t, long steps,
+        int scale) {
+    trace_cursor_t c;
+    if (scale < 1 || trace_seek(t, &c, steps) != 1)
+        return 0;
+    point_t last = {c.idx % m->stride, c.idx / m->stride};
+
+    image_out_t o = {0};
+    o.format = image_format(fname);
+    o.w = (m->c + scale - 1) / scale;
+    o.h = (m->r + scale - 1) / scale;
+    o.row_len = o.w * (o.format == FMT_PGM ? 1 : 3) + (o.format == FMT_PNG);
+
+    /* the rows of visit counts that fit in IMAGE_BAND_BYTES */
+    long band = IMAGE_BAND_BYTES / (o.w * (long) sizeof(uint32_t));
+    if (band < 1)
+        band = 1;
+    if (band > o.h)
+        band = o.h;
+
+    uint32_t *counts = malloc(band * o.w * sizeof(uint32_t));
+    long *walls = malloc(o.w * sizeof(long));
+    o.row = calloc(o.row_len, 1);
+    o.f = fopen(fname, "wb");
+    if (!counts || !walls || !o.row || !o.f) {
+        if (o.f)
+            fclose(o.f);
+        free(counts);
+        free(walls);
+        free(o.row);
+        return 0;
+    }
+    setvbuf(o.f, NULL, _IOFBF, 1 << 16);
+    init_crc();
+    write_header(&o);
+
+    /* the marks are squares, so they stay visible on large pictures */
+    long rad = (o.w < o.h ? o.w : o.h) / 256;
+    point_t marks[3] = {m->start, m->exit, last};
+    const uint8_t *mark_col[3] = {col_start, col_exit, col_walker};
+
+    uint8_t *pixels = o.row + (o.format == FMT_PNG);
+    for (long b0 = 0; b0 < o.h; b0 += band) {
+        long b1 = b0 + band < o.h ? b0 + band : o.h;
+        memset(counts, 0, band * o.w * sizeof(uint32_t));
+        count_visits(m, t, steps, scale, b0, b1, o.w, counts);
+
+        for (long py = b0; py < b1; py++) {
+            long y0 = py * scale, y1 = y0 + scale < m->r ? y0 + scale : m->r;
+            memset(walls, 0, o.w * sizeof(long));
+            for (long y = y0; y < y1; y++) {
+                long idx = maze_idx(m, (point_t) {0, y});
+                for (long x = 0; x < m->c; x++, idx++)
+                    walls[x / scale] += !maze_open(m, idx);
+            }
+
+            uint32_t *row_counts = counts + (py - b0) * o.w;
+            for (long px = 0; px < o.w; px++) {
+                long x0 = px * scale;
+                long x1 = x0 + scale < m->c ? x0 + scale : m->c;
+                uint8_t rgb[3];
+                block_colour(rgb, walls[px], (x1 - x0) * (y1 - y0),
+                        row_counts[px]);
+                for (int i = 2; i >= 0; i--) {
+                    if (labs(marks[i].x / scale - px) <= rad
+                            && labs(marks[i].y / scale - py) <= rad) {
+                        memcpy(rgb, mark_col[i], 3);
+                        break;
+                    }
+                }
+                if (o.format == FMT_PGM)
+                    pixels[px] = (77 * rgb[0] + 150 * rgb[1] + 29 * rgb[2]) >> 8;
+                else
+                    memcpy(pixels + 3 * px, rgb, 3);
+            }
+            write_row(&o, py == 0);
+        }
+    }
+    write_trailer(&o);
+
+    int ok = !ferror(o.f);
+    ok &= fclose(o.f) == 0;
+    free(counts);
+    free(walls);
+    free(o.row);
+    return ok;
+}
@@ -0,0 +1,48 @@
+/*
+ * Image export
+ *
+ * Writes a picture of a maze and of the walk recorded in a trace, see
+ * trace.h. The picture is streamed a row at a time, so only the rows
+ * that are being written are kept in memory whatever the size of the
+ * maze. The format follows the extension of the file name:
+ *
+ *     .pgm  binary PGM, grey
+ *     .png  PNG with stored (uncompressed) deflate blocks, colour
+ *     else  binary PPM, colour
+ *
+ * Every pixel shows a block of scale * scale tiles. Open tiles are white
+ * and walls black, a block of both is grey. Blocks the walker visited are
+ * coloured by the visits per open tile, from yellow for a single visit to
+ * red for IMAGE_HEAT_MAX visits or more, so the path of a search solver
+ * is a yellow line. The start, the exit and the last position of the
+ * walker are marked green, red and blue.
+ */
+
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include "maze.h"
+#include "trace.h"
+
+/* the visits per open tile that get the hottest colour */
+#define IMAGE_HEAT_MAX 1024
+
+/*
+ * The memory for the visit counts in bytes. When the counts of the
+ * whole picture do not fit, the trace is read once per band of rows that
+ * does.
+ */
+#define IMAGE_BAND_BYTES (64L << 20)
+
+/*
+ * Writes the picture of m and of the first steps of the walk in t to
+ * fname, every pixel showing scale * scale tiles
+ *
+ * returns 1 on success
+ * returns 0 when the file can not be written, when steps is not in the
+ * trace or when out of memory
+ */
+int write_image(const char *fname, maze_t *m, trace_t *t, long steps,
+        int scale);
+
+#endif /* IMAGE_H */
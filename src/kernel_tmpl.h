@@ -0,0 +1,116 @@
+/*
+ * Template of the step kernels, included by kernels.c once per backend.
+ * No include guard on purpose.
+ *
+ * Before including define:
+ *   KERNEL_GRID        the name of the backend, appended to the names
+ *   KERNEL_DECL        declarations of the locals KERNEL_MASK uses
+ *   KERNEL_MASK(idx)   the open direction mask of tile idx
+ */
+
+#define KERNEL_CAT_(a, b) a##_##b
+#define KERNEL_CAT(a, b) KERNEL_CAT_(a, b)
+#define KERNEL_NAME(f) KERNEL_CAT(f, KERNEL_GRID)
+
+static int KERNEL_NAME(rand_run)(maze_t *m, walker_t *w, long max_steps,
+        long *steps) {
+    KERNEL_DECL
+    const long off[4] = {m->off[0], m->off[1], m->off[2], m->off[3]};
+    long idx = w->idx, exit = maze_idx(m, m->exit);
+    rng_t rng = w->rng;
+    int status = RUN_BUDGET;
+    long n = 0;
+
+    while (n < max_steps) {
+        int mask = KERNEL_MASK(idx);
+        n++;
+        if (mask_count[mask])
+            idx += off[mask_select[mask][rng_below(&rng, mask_count[mask])]];
+        if (idx == exit) {
+            status = RUN_EXIT;
+            break;
+        }
+    }
+
+    w->rng = rng;
+    place_walker(m, w, idx);
+    *steps = n;
+    return status;
+}
+
+static int KERNEL_NAME(randi_run)(maze_t *m, walker_t *w, long max_steps,
+        long *steps) {
+    KERNEL_DECL
+    const long off[4] = {m->off[0], m->off[1], m->off[2], m->off[3]};
+    long idx = w->idx, exit = maze_idx(m, m->exit);
+    direction_t nd = w->dir;
+    rng_t rng = w->rng;
+    int status = RUN_BUDGET;
+    long n = 0;
+
+    while (n < max_steps) {
+        int all = KERNEL_MASK(idx);
+        direction_t od = (nd + 2) & 3;
+        int mask = all & ~(1 << od);
+        n++;
+
+        nd = mask_count[mask]
+            ? mask_select[mask][rng_below(&rng, mask_count[mask])] : od;
+        if ((all >> nd) & 1)
+            idx += off[nd];
+        if (idx == exit) {
+            status = RUN_EXIT;
+            break;
+        }
+    }
+
+    w->dir = nd;
+    w->rng = rng;
+    place_walker(m, w, idx);
+    *steps = n;
+    return status;
+}
+
+static int KERNEL_NAME(wall_run)(maze_t *m, walker_t *w, long max_steps,
+        long *steps) {
+    KERNEL_DECL
+    const long off[4] = {m->off[0], m->off[1], m->off[2], m->off[3]};
+    long idx = w->idx, exit = maze_idx(m, m->exit);
+    direction_t cd = w->dir;
+    cycle_t c = w->cycle;
+    int status = RUN_BUDGET;
+    long n = 0;
+
+    while (n < max_steps) {
+        int mask = KERNEL_MASK(idx);
+        if (!mask) {
+            /* walled in, every step stays in place */
+            n = max_steps;
+            break;
+        }
+        if (cycle_step(&c, idx, cd)) {
+            status = RUN_HALT;
+            break;
+        }
+        cd = wall_turn[mask][cd];
+        idx += off[cd];
+        n++;
+        if (idx == exit) {
+            status = RUN_EXIT;
+            break;
+        }
+    }
+
+    w->dir = cd;
+    w->cycle = c;
+    place_walker(m, w, idx);
+    *steps = n;
+    return status;
+}
+
+#undef KERNEL_NAME
+#undef KERNEL_CAT
+#undef KERNEL_CAT_
+#undef KERNEL_GRID
+#undef KERNEL_DECL
+#undef KERNEL_MASK
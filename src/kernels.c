@@ -0,0 +1,111 @@
+/*
+ * Step kernels of the walking solvers, generated per backend
+ */
+
+#include <stdlib.h>
+#include "mazedef.h"
+#include "walkerdef.h"
+#include "solvers.h"
+#include "kernels.h"
+
+const int mask_count[16] = {
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+};
+
+const direction_t mask_select[16][4] = {
+    {0}, {NORTH}, {EAST}, {NORTH, EAST},
+    {SOUTH}, {NORTH, SOUTH}, {EAST, SOUTH}, {NORTH, EAST, SOUTH},
+    {WEST}, {NORTH, WEST}, {EAST, WEST}, {NORTH, EAST, WEST},
+    {SOUTH, WEST}, {NORTH, SOUTH, WEST}, {EAST, SOUTH, WEST},
+    {NORTH, EAST, SOUTH, WEST},
+};
+
+/* go right by default, rotate left until a path is found */
+const direction_t wall_turn[16][4] = {
+    {NORTH, EAST, SOUTH, WEST},
+    {NORTH, NORTH, NORTH, NORTH},
+    {EAST, EAST, EAST, EAST},
+    {EAST, EAST, EAST, NORTH},
+    {SOUTH, SOUTH, SOUTH, SOUTH},
+    {NORTH, SOUTH, SOUTH, NORTH},
+    {EAST, SOUTH, SOUTH, SOUTH},
+    {EAST, SOUTH, SOUTH, NORTH},
+    {WEST, WEST, WEST, WEST},
+    {NORTH, NORTH, WEST, NORTH},
+    {EAST, EAST, WEST, WEST},
+    {EAST, EAST, WEST, NORTH},
+    {WEST, SOUTH, WEST, WEST},
+    {NORTH, SOUTH, WEST, NORTH},
+    {EAST, SOUTH, WEST, WEST},
+    {EAST, SOUTH, WEST, NORTH},
+};
+
+/* bytes with the open direction masks */
+#define KERNEL_GRID masks
+#define KERNEL_DECL const unsigned char *open = m->open;
+#define KERNEL_MASK(idx) (open[idx])
+#include "kernel_tmpl.h"
+
+/* bytes only */
+#define KERNEL_GRID bytes
+#define KERNEL_DECL \
+    const char *cells = m->cells; \
+    const long stride = m->stride;
+#define KERNEL_MASK(idx) \
+    ((cells[(idx) - stride] != WALL) << NORTH \
+     | (cells[(idx) + 1] != WALL) << EAST \
+     | (cells[(idx) + stride] != WALL) << SOUTH \
+     | (cells[(idx) - 1] != WALL) << WEST)
+#include "kernel_tmpl.h"
+
+/*
+ * Returns bit b of the packed grid bits
+ */
+static inline int grid_bit(const uint64_t *bits, long b) {
+    return (bits[b >> 6] >> (b & 63)) & 1;
+}
+
+/* the packed grid, bit idx + bbase is tile idx */
+#define KERNEL_GRID bits
+#define KERNEL_DECL \
+    const uint64_t *bits = m->bits; \
+    const long stride = m->stride, bbase = m->bbase;
+#define KERNEL_MASK(idx) \
+    (grid_bit(bits, (idx) + bbase - stride) << NORTH \
+     | grid_bit(bits, (idx) + bbase + 1) << EAST \
+     | grid_bit(bits, (idx) + bbase + stride) << SOUTH \
+     | grid_bit(bits, (idx) + bbase - 1) << WEST)
+#include "kernel_tmpl.h"
+
+typedef int (*kernel_t)(maze_t *, walker_t *, long, long *);
+
+/* the kernels of every backend, indexed by grid_backend_t */
+static const kernel_t rand_kernels[GRID_BACKENDS] = {
+    rand_run_masks, rand_run_bytes, rand_run_bits,
+};
+static const kernel_t randi_kernels[GRID_BACKENDS] = {
+    randi_run_masks, randi_run_bytes, randi_run_bits,
+};
+static const kernel_t wall_kernels[GRID_BACKENDS] = {
+    wall_run_masks, wall_run_bytes, wall_run_bits,
+};
+
+grid_backend_t grid_backend(const maze_t *m) {
+    if (m->bits)
+        return GRID_BITS;
+    if (m->open)
+        return GRID_MASKS;
+    return GRID_BYTES;
+}
+
+int rand_walker_run(maze_t *m, walker_t *w, long max_steps, long *steps) {
+    return rand_kernels[grid_backend(m)](m, w, max_steps, steps);
+}
+
+int randi_walker_run(maze_t *m, walker_t *w, long max_steps, long *steps) {
+    return randi_kernels[grid_backend(m)](m, w, max_steps, steps);
+}
+
+int wall_follower_run(maze_t *m, walker_t *w, long max_steps, long *steps) {
+    return wall_kernels[grid_backend(m)](m, w, max_steps, steps);
+}
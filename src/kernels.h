@@ -0,0 +1,103 @@
+/*
+ * Step kernels of the walking solvers
+ *
+ * The run functions of the random walkers and the wall follower are
+ * generated once for every way a maze can be stored, from the template
+ * in kernel_tmpl.h. The kernel matching the maze is picked from a table
+ * when the run starts, so the inner loop reads the grid directly and
+ * keeps all state in registers.
+ */
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "point.h"
+#include "maze.h"
+
+/*
+ * The ways the tiles of a maze can be stored
+ */
+typedef enum {
+    /* bytes, with the open direction masks built */
+    GRID_MASKS = 0,
+    /* bytes only */
+    GRID_BYTES,
+    /* the packed grid */
+    GRID_BITS,
+    GRID_BACKENDS,
+} grid_backend_t;
+
+/*
+ * Brent's cycle detection for deterministic solvers.
+ * The state of such a solver is its position and a direction. Once a
+ * state repeats the solver walks in a circle, and if the exit was not
+ * found on the way it never will be. Uses constant memory and notices a
+ * repeat at most twice the length of the walk up to the cycle and the
+ * cycle itself after it starts.
+ */
+typedef struct cycle_t {
+    /* the saved state */
+    long idx;
+    int dir;
+    /* the number of states between saves and the states since the last */
+    long power, lam;
+} cycle_t;
+
+/* number of directions in an open direction mask */
+extern const int mask_count[16];
+
+/* mask_select[mask][n] is the n-th direction set in mask */
+extern const direction_t mask_select[16][4];
+
+/*
+ * wall_turn[mask][dir] is the move of a walker keeping a wall on its
+ * right hand, that moved in direction dir and can move in the directions
+ * of mask
+ */
+extern const direction_t wall_turn[16][4];
+
+/*
+ * Starts cycle detection, the first state is passed to cycle_step()
+ */
+static inline void cycle_init(cycle_t *c) {
+    /* no state saved yet */
+    c->idx = -1;
+    c->dir = -1;
+    c->power = 1;
+    c->lam = 0;
+}
+
+/*
+ * Records the next state of the solver
+ *
+ * returns 1 if the state is a repeat of an earlier state
+ * returns 0 otherwise
+ */
+static inline int cycle_step(cycle_t *c, long idx, int dir) {
+    if (idx == c->idx && dir == c->dir)
+        return 1;
+
+    /* move the saved state forward every power of two steps */
+    if (++c->lam == c->power) {
+        c->idx = idx;
+        c->dir = dir;
+        c->power *= 2;
+        c->lam = 0;
+    }
+    return 0;
+}
+
+/*
+ * Returns how the tiles of m are stored
+ */
+grid_backend_t grid_backend(const maze_t *m);
+
+/*
+ * Run functions of the walking solvers, see algorithm_t.
+ * Each calls the kernel for the backend of the maze.
+ */
+int rand_walker_run(maze_t *m, walker_t *w, long max_steps, long *steps);
+int randi_walker_run(maze_t *m, walker_t *w, long max_steps, long *steps);
+int wall_follower_run(maze_t *m, walker_t *w, long max_steps, long *steps);
+
+#endif /* KERNELS_H */
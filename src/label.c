@@ -0,0 +1,168 @@
+/*
+ * Connected component labelling with union-find over row strips
+ */
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "mazedef.h"
+#include "label.h"
+
+/*
+ * The work of a labelling thread
+ */
+typedef struct strip_t {
+    maze_t *m;
+    /* union-find parents, indexed like the cells of the maze */
+    long *parent;
+    /* the rows [y0, y1) of the strip */
+    int y0, y1;
+} strip_t;
+
+/*
+ * Returns the root of the set of idx, halving the path on the way
+ */
+static long find(long *parent, long idx) {
+    while (parent[idx] != idx) {
+        parent[idx] = parent[parent[idx]];
+        idx = parent[idx];
+    }
+    return idx;
+}
+
+/*
+ * Merges the sets of a and b, the smaller root becomes the root
+ */
+static void unite(long *parent, long a, long b) {
+    a = find(parent, a);
+    b = find(parent, b);
+    if (a < b)
+        parent[b] = a;
+    else if (b < a)
+        parent[a] = b;
+}
+
+/*
+ * Unites the open tiles of a strip with their open west and north
+ * neighbours inside the strip
+ */
+static void* label_strip(void *arg) {
+    strip_t *s = arg;
+    maze_t *m = s->m;
+    for (int y = s->y0; y < s->y1; y++) {
+        long row = maze_idx(m, (point_t) {0, y});
+        for (long idx = row; idx < row + m->c; idx++) {
+            if (!maze_open(m, idx))
+                continue;
+            s->parent[idx] = idx;
+            if (idx > row && maze_open(m, idx - 1))
+                unite(s->parent, idx, idx - 1);
+            if (y > s->y0 && maze_open(m, idx - m->stride))
+                unite(s->parent, idx, idx - m->stride);
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Stores the component of every tile of a strip, the roots must have
+ * their component already
+ */
+static void* number_strip(void *arg) {
+    strip_t *s = arg;
+    maze_t *m = s->m;
+    for (int y = s->y0; y < s->y1; y++) {
+        long row = maze_idx(m, (point_t) {0, y});
+        for (long idx = row; idx < row + m->c; idx++) {
+            if (!maze_open(m, idx)) {
+                m->comp[idx] = NO_COMP;
+                continue;
+            }
+            /* no path halving, the other threads read the parents too */
+            long root = idx;
+            while (s->parent[root] != root)
+                root = s->parent[root];
+            if (root != idx)
+                m->comp[idx] = m->comp[root];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Runs f over all strips, on a thread per strip.
+ * Strips whose thread can not be created run on the calling thread.
+ */
+static void run_strips(strip_t *strips, int n, void* (*f)(void *)) {
+    pthread_t *tids = malloc(sizeof(pthread_t) * n);
+    int *started = calloc(n, sizeof(int));
+    for (int i = 1; i < n; i++)
+        if (tids && started)
+            started[i] = !pthread_create(&tids[i], NULL, f, &strips[i]);
+    f(&strips[0]);
+    for (int i = 1; i < n; i++) {
+        if (started && started[i])
+            pthread_join(tids[i], NULL);
+        else
+            f(&strips[i]);
+    }
+    free(tids);
+    free(started);
+}
+
+long label_components(maze_t *m, int threads) {
+    long size = (long) m->r * m->stride;
+    if (threads > m->r)
+        threads = m->r;
+    if (threads < 1)
+        threads = 1;
+
+    free(m->comp);
+    m->ncomp = 0;
+    m->comp = malloc(sizeof(uint32_t) * size);
+    long *parent = malloc(sizeof(long) * size);
+    strip_t *strips = malloc(sizeof(strip_t) * threads);
+    if (!m->comp || !parent || !strips) {
+        free(m->comp);
+        m->comp = NULL;
+        free(parent);
+        free(strips);
+        return -1;
+    }
+
+    for (int i = 0; i < threads; i++) {
+        strips[i].m = m;
+        strips[i].parent = parent;
+        strips[i].y0 = (long) m->r * i / threads;
+        strips[i].y1 = (long) m->r * (i + 1) / threads;
+    }
+    run_strips(strips, threads, label_strip);
+
+    /* merge the strips along their borders */
+    for (int i = 1; i < threads; i++) {
+        long row = maze_idx(m, (point_t) {0, strips[i].y0});
+        for (long idx = row; idx < row + m->c; idx++)
+            if (maze_open(m, idx) && maze_open(m, idx - m->stride))
+                unite(parent, idx, idx - m->stride);
+    }
+
+    /* number the roots in the order they appear */
+    long n = 0;
+    for (int y = 0; y < m->r; y++) {
+        long row = maze_idx(m, (point_t) {0, y});
+        for (long idx = row; idx < row + m->c; idx++)
+            if (maze_open(m, idx) && parent[idx] == idx)
+                m->comp[idx] = n++;
+    }
+    run_strips(strips, threads, number_strip);
+
+    free(parent);
+    free(strips);
+    m->ncomp = n;
+    return n;
+}
+
+uint32_t tile_component(maze_t *m, point_t p) {
+    if (!m->comp)
+        return NO_COMP;
+    return m->comp[maze_idx(m, p)];
+}
@@ -0,0 +1,35 @@
+/*
+ * Connected component labelling
+ *
+ * Labels the connected regions of open tiles, so a maze whose start and
+ * exit lie in different regions can be rejected before it is solved.
+ */
+
+#ifndef LABEL_H
+#define LABEL_H
+
+#include <stdint.h>
+#include "point.h"
+#include "maze.h"
+
+/* the component of a wall */
+#define NO_COMP UINT32_MAX
+
+/*
+ * Labels the connected components of the open tiles of m on the given
+ * number of threads and stores them in m->comp and m->ncomp.
+ * Every thread runs union-find over a strip of rows, the strips are
+ * merged afterwards.
+ *
+ * returns the number of components
+ * returns -1 when out of memory
+ */
+long label_components(maze_t *m, int threads);
+
+/*
+ * Returns the component of the tile on point p, NO_COMP for walls or
+ * when m is not labelled
+ */
+uint32_t tile_component(maze_t *m, point_t p);
+
+#endif /* LABEL_H */
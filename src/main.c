@@ -8,21 +8,40 @@
 
 #include <stdio.h>
 #include <getopt.h>
-#include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "renderer.h"
 #include "point.h"
 #include "walkerdef.h"
+#include "mazedef.h"
 #include "maze.h"
 #include "solvers.h"
+#include "flood.h"
+#include "label.h"
+#include "swarm.h"
+#include "trials.h"
+#include "frames.h"
+#include "overview.h"
+#include "trace.h"
+#include "image.h"
+#include "timing.h"
 
 #define DEFAULT_STEPS 1000000
 #define DEFAULT_WIDTH  80
 #define DEFAULT_HEIGHT  24
 #define DEFAULT_ALGO "wallfollower"
 #define DEFAULT_DELAY 10
+#define DEFAULT_FPS 30
+
+/* the steps a solver takes between two looks at the render thread when
+ * it runs at full speed */
+#define RUN_CHUNK 4096
+
+/* exit status when the solver proves it can not reach the exit */
+#define EXIT_UNSOLVABLE 2
 
 /* getopt variables */
 extern char *optarg;
@@ -30,12 +49,44 @@ extern int optind;
 
 extern int mazewarn;
 
-/* the delay between render frames in nanoseconds */
-unsigned int delay = DEFAULT_DELAY;
+/* the delay between two steps in milliseconds, 0 = full speed */
+int delay = DEFAULT_DELAY;
+/* the number of steps per second when it is not set by delay, 0 = unset */
+double speed = 0;
+/* the number of frames drawn per second */
+int fps = DEFAULT_FPS;
+/* the size of the screen, 0 = the size of the terminal */
+int sw = 0, sh = 0;
+/* 1 = show a zoomed out overview of the maze instead of the tiles */
+int overview = 0;
 /* the maximum number of steps */
 long steps = DEFAULT_STEPS;
 /* 0 = no-render, 1 = render */
 int render = 1;
+/* 1 = store the maze with one bit per tile */
+int packed = 0;
+/* 1 = fill the dead ends of the maze before solving */
+int prune = 0;
+/* 1 = check whether the exit can be reached before solving */
+int reach = 0;
+/* 1 = label the connected components before solving */
+int label = 0;
+/* the number of walkers of a swarm, 0 = a single walker */
+long swarm_size = 0;
+/* the number of Monte Carlo trials, 0 = a single walk */
+long trials = 0;
+/* 1 = the seed was given by the user */
+int seeded = 0;
+/* the trace file the walk is recorded to, NULL = no recording */
+const char *record = NULL;
+/* the trace file that is replayed, NULL = solve the maze */
+const char *replay = NULL;
+/* the step the replay starts at */
+long from = 0;
+/* the picture of the walk that is written, NULL = no picture */
+const char *image = NULL;
+/* the tiles per pixel along each side of the picture */
+int scale = 1;
 
 /*
  * prints usage
@@ -51,17 +102,79 @@ void usage(int err);
  */
 int prompt(const char *msg);
 
+/*
+ * sets the size of the viewport and clears the terminal
+ * without -x and -y the size of the terminal is used, or the default size
+ * when the output is not a terminal
+ */
+void init_screen(void);
+
+/*
+ * returns the time between two steps in seconds, 0 = full speed
+ */
+double step_period(void);
+
+/*
+ * sleeps until the next step is due, next is the time the last step was
+ * due, see step_period()
+ */
+void pace(double *next);
+
+/*
+ * starts the render thread, with the overview of the maze when it is
+ * turned on, focussed on focus
+ * returns NULL on failure
+ */
+frames_t* start_view(maze_t *maze, point_t focus, overview_t **ov);
+
+/*
+ * draws the final frame, the walker on tile index idx, and stops the
+ * render thread
+ */
+void stop_view(frames_t *f, overview_t *ov, long idx);
+
+/*
+ * writes the picture of the first steps of the walk in t to image
+ * returns 1 on success
+ */
+int export_image(maze_t *maze, trace_t *t, long steps);
+
+/*
+ * plays the trace replay back from step from
+ * returns the exit status of the program
+ */
+int run_replay(maze_t *maze);
+
+/*
+ * runs a swarm of swarm_size random walkers on maze
+ * returns the exit status of the program
+ */
+int run_swarm(maze_t *maze);
+
 /* the algorithm that is used */
 algorithm_t *algo;
 
 int main (int argc, char **argv) {
     maze_t* maze;
 
-    int sw = DEFAULT_WIDTH;
-    int sh = DEFAULT_HEIGHT;
-
-    char opt;
-    while ((opt = getopt(argc, argv, "ha:cd:s:x:y:n")) != (char) -1) {
+    /* the long options without a short option use values above 255 */
+    enum { OPT_SEED = 256, OPT_RECORD, OPT_REPLAY, OPT_FROM, OPT_SPEED,
+        OPT_IMAGE, OPT_SCALE };
+    static const struct option longopts[] = {
+        {"seed", required_argument, NULL, OPT_SEED},
+        {"trials", required_argument, NULL, 'm'},
+        {"record", required_argument, NULL, OPT_RECORD},
+        {"replay", required_argument, NULL, OPT_REPLAY},
+        {"from", required_argument, NULL, OPT_FROM},
+        {"speed", required_argument, NULL, OPT_SPEED},
+        {"image", required_argument, NULL, OPT_IMAGE},
+        {"scale", required_argument, NULL, OPT_SCALE},
+        {NULL, 0, NULL, 0},
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "ha:cd:f:s:x:y:nbt:rplw:m:o",
+                    longopts, NULL)) != -1) {
         switch (opt) {
             case 'a':
                 algo = get_algo(optarg);
@@ -84,6 +197,14 @@ int main (int argc, char **argv) {
                 }
                 break;
 
+            case 'f':
+                fps = atoi(optarg);
+                if (fps <= 0) {
+                    fprintf(stderr, "-f expects a positive integer\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+
             case 'c':
                 rs_set_coloured(1);
                 break;
@@ -116,11 +237,106 @@ int main (int argc, char **argv) {
                 render = 0;
                 break;
 
+            case 'o':
+                overview = 1;
+                break;
+
+            case 'b':
+                packed = 1;
+                break;
+
+            case 'p':
+                prune = 1;
+                break;
+
+            case 'l':
+                label = 1;
+                break;
+
+            case 'r':
+                reach = 1;
+                break;
+
+            case 'w':
+                swarm_size = atol(optarg);
+                if (swarm_size <= 0) {
+                    fprintf(stderr, "-w expects a positive integer\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case 'm':
+                trials = atol(optarg);
+                if (trials <= 0) {
+                    fprintf(stderr, "--trials expects a positive integer\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case OPT_SEED:
+                ss_set_seed(strtoull(optarg, NULL, 0));
+                seeded = 1;
+                break;
+
+            case OPT_RECORD:
+                record = optarg;
+                break;
+
+            case OPT_REPLAY:
+                replay = optarg;
+                break;
+
+            case OPT_FROM:
+                from = atol(optarg);
+                if (from < 0) {
+                    fprintf(stderr, "--from expects a positive integer or 0\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case OPT_IMAGE:
+                image = optarg;
+                break;
+
+            case OPT_SCALE:
+                scale = atoi(optarg);
+                if (scale < 1) {
+                    fprintf(stderr, "--scale expects a positive integer\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case OPT_SPEED:
+                speed = atof(optarg);
+                if (speed <= 0) {
+                    fprintf(stderr, "--speed expects a positive number\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case 't':
+                if (atoi(optarg) <= 0) {
+                    fprintf(stderr, "-t expects a positive integer\n");
+                    return EXIT_FAILURE;
+                }
+                ss_set_threads(atoi(optarg));
+                break;
+
             case '?':
                 return EXIT_FAILURE;
         }
     }
 
+    if (!seeded)
+        ss_set_seed(time(NULL));
+
+    if (replay && prune) {
+        /* the filled dead ends may be tiles the recorded walk went through */
+        fprintf(stderr, "-p can not be used with --replay, the trace was "
+                "recorded on the whole maze\n");
+        return EXIT_FAILURE;
+    }
+
     /* no solver algorithm specified by user, use the default algorithm */
     if (!algo)
         algo = get_algo(DEFAULT_ALGO);
@@ -129,49 +345,229 @@ int main (int argc, char **argv) {
         usage(EXIT_FAILURE);
 
     /* read and parse the maze */
-    maze = read_maze(argv[optind]);
+    maze = read_maze(argv[optind], packed);
 
     if (!maze) {
         fprintf(stderr, "Error while reading maze file\n");
         return 1;
     }
+    build_open_masks(maze);
+
+    if (prune) {
+        double t = now_sec();
+        long open = 0, filled = fill_dead_ends(maze, &open);
+        if (filled < 0) {
+            fprintf(stderr, "Out of memory while filling dead ends\n");
+            return EXIT_FAILURE;
+        }
+        fprintf(stderr, "filled %ld of %ld open tiles (%.1f%%) in %.3f ms\n",
+                filled, open, open ? 100.0 * filled / open : 0.0,
+                (now_sec() - t) * 1e3);
+    }
+
+    if (reach) {
+        double t = now_sec();
+        int r = flood_reachable(maze, maze->start, maze->exit);
+        if (r < 0) {
+            fprintf(stderr, "Out of memory while checking reachability\n");
+            return EXIT_FAILURE;
+        }
+        fprintf(stderr, "reachability check took %.3f ms\n",
+                (now_sec() - t) * 1e3);
+        if (r == 0) {
+            fprintf(stderr, "The exit can not be reached from the start\n");
+            return EXIT_UNSOLVABLE;
+        }
+    }
+
+    if (label) {
+        double t = now_sec();
+        long n = label_components(maze, ss.threads);
+        if (n < 0) {
+            fprintf(stderr, "Out of memory while labelling the maze\n");
+            return EXIT_FAILURE;
+        }
+        fprintf(stderr, "labelled %ld components on %d threads in %.3f ms\n",
+                n, ss.threads, (now_sec() - t) * 1e3);
+        if (tile_component(maze, maze->start)
+                != tile_component(maze, maze->exit)) {
+            fprintf(stderr, "The start and the exit are not connected\n");
+            return EXIT_UNSOLVABLE;
+        }
+    }
+
     if (mazewarn) {
         int cont = prompt("There were some errors in the maze file, are you sure you want to continue?");
         if (!cont)
             return EXIT_SUCCESS;
     }
+
+    if (replay)
+        return run_replay(maze);
+
+    if ((swarm_size || trials) && image) {
+        fprintf(stderr, "A picture can only show a single walker\n");
+        return EXIT_FAILURE;
+    }
+
+    if (swarm_size) {
+        if (overview && render) {
+            fprintf(stderr, "The overview can not show a swarm\n");
+            return EXIT_FAILURE;
+        }
+        return run_swarm(maze);
+    }
+
+    if (trials) {
+        if (!algo->run) {
+            fprintf(stderr, "'%s' can not run trials\n", algo->name);
+            return EXIT_FAILURE;
+        }
+        fprintf(stderr, "seed %llu\n", (unsigned long long) ss.seed);
+        int r = run_trials(maze, algo, trials, steps, ss.threads, ss.seed);
+        if (r < 0)
+            return EXIT_UNSOLVABLE;
+        if (r == 0) {
+            fprintf(stderr, "Failed to run the trials of '%s'\n",
+                    algo->name);
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
     
     walker_t *walker = init_walker(maze, algo->funct);
 
-    /* change renderer settings and clear terminal */
+    /* change renderer settings and clear terminal, the render thread
+     * sets the focus */
     if (render) {
-        rs_detect_dim();
-        rs_set_focus(&(walker->pos));
-        clear_term();
+        init_screen();
+    }
+
+    /* the solver has told why it can not reach the exit */
+    int init = algo->init ? algo->init(maze, walker) : INIT_OK;
+    if (init == INIT_UNREACHABLE)
+        return EXIT_UNSOLVABLE;
+    if (init != INIT_OK) {
+        fprintf(stderr, "Failed to initialise algorithm '%s'\n", algo->name);
+        return EXIT_FAILURE;
     }
 
-    if(algo->init)
-        algo->init(walker);
+    /* the picture is drawn from a trace, a temporary one without --record */
+    char tmp_trace[] = "/tmp/mazetrace_XXXXXX";
+    const char *trace_file = record;
+    if (image && !record) {
+        int fd = mkstemp(tmp_trace);
+        if (fd < 0 || close(fd)) {
+            fprintf(stderr, "Failed to create a temporary trace\n");
+            return EXIT_FAILURE;
+        }
+        trace_file = tmp_trace;
+    }
+
+    trace_writer_t *tw = NULL;
+    if (trace_file && !(tw = trace_create(trace_file, maze, walker,
+                    algo->name, ss.seed))) {
+        fprintf(stderr, "Failed to create the trace '%s'\n", trace_file);
+        return EXIT_FAILURE;
+    }
 
     long count = 0L;
-    int err;
-    while (count < steps) {
-        count++;
-        /* logic */
-        walker_step(maze, walker);
-        if (at_exit(maze, walker))
-            break;
-        /* render */
-        if(render && (err = render_maze(maze, walker) != MRSUCC))
-            mrerror("Error while rendering", err);
-        /* sleep */
-        /* FIXME: usleep is depricated, use nanosleep instead */
-        if (delay)
-            usleep(delay * 1000);
-    }
-
-    if (count < steps)
+    int status = RUN_BUDGET, recorded = 1;
+    double t = now_sec();
+    if (!render && algo->run && !tw) {
+        /* nothing to show, let the solver take all steps at once */
+        status = algo->run(maze, walker, steps, &count);
+    } else if (!render) {
+        while (count < steps) {
+            long from_idx = walker->idx;
+            if (walker_step(maze, walker) < 0) {
+                status = RUN_HALT;
+                break;
+            }
+            count++;
+            if (tw && !(recorded = trace_step(tw, walker, from_idx)))
+                break;
+            if (at_exit(maze, walker)) {
+                status = RUN_EXIT;
+                break;
+            }
+        }
+    } else {
+        overview_t *ov;
+        frames_t *f = start_view(maze, walker->pos, &ov);
+        if (!f)
+            return EXIT_FAILURE;
+        double next = now_sec();
+        while (count < steps) {
+            /* the trail of the overview and the trace need every step */
+            if (!step_period() && algo->run && !ov && !tw) {
+                long n, chunk = steps - count;
+                if (chunk > RUN_CHUNK)
+                    chunk = RUN_CHUNK;
+                status = algo->run(maze, walker, chunk, &n);
+                count += n;
+                if (status != RUN_BUDGET)
+                    break;
+            } else {
+                long from_idx = walker->idx;
+                if (walker_step(maze, walker) < 0) {
+                    status = RUN_HALT;
+                    break;
+                }
+                count++;
+                if (tw && !(recorded = trace_step(tw, walker, from_idx)))
+                    break;
+                if (ov)
+                    overview_visit(ov, walker->pos);
+                if (at_exit(maze, walker)) {
+                    status = RUN_EXIT;
+                    break;
+                }
+            }
+            if (frame_wanted(f))
+                frame_walker(f, walker->idx);
+            pace(&next);
+        }
+        stop_view(f, ov, walker->idx);
+    }
+    if (!render) {
+        t = now_sec() - t;
+        fprintf(stderr, "took %ld steps in %.3f ms (%.1f M steps/s)\n",
+                count, t * 1e3, t > 0 ? count / t / 1e6 : 0.0);
+    }
+
+    if (tw) {
+        long bytes;
+        if (!trace_close(tw, &bytes) || !recorded) {
+            fprintf(stderr, "Failed to record step %ld to '%s'\n", count,
+                    trace_file);
+            if (trace_file == tmp_trace)
+                unlink(tmp_trace);
+            return EXIT_FAILURE;
+        }
+        if (record)
+            fprintf(stderr, "recorded %ld steps in %ld bytes (%.2f bits per"
+                    " step) to '%s'\n", count, bytes,
+                    count ? 8.0 * bytes / count : 0.0, record);
+    }
+
+    if (image) {
+        trace_t *tr = trace_open(trace_file, maze);
+        int ok = tr && export_image(maze, tr, count);
+        trace_free(tr);
+        if (trace_file == tmp_trace)
+            unlink(tmp_trace);
+        if (!ok)
+            return EXIT_FAILURE;
+    }
+
+    if (status == RUN_HALT)
+        printf("'%s' can not reach the exit, gave up after %ld steps\n",
+                algo->name, count);
+    else if (status == RUN_EXIT)
         printf("Found exit after %ld steps\n", count);
+    if (algo->report)
+        algo->report(walker->state);
 
     /* free walker->state through algo, since algo is tasked with
      * (initialization and) cleanup of walker->state */
@@ -179,30 +575,261 @@ int main (int argc, char **argv) {
         algo->free(walker->state);
 
     cleanup_walker(walker);
+    return status == RUN_HALT ? EXIT_UNSOLVABLE : EXIT_SUCCESS;
+}
+
+int run_swarm(maze_t *maze) {
+    int avoid_back;
+    if (strcmp(algo->name, "random") == 0) {
+        avoid_back = 0;
+    } else if (strcmp(algo->name, "randomi") == 0) {
+        avoid_back = 1;
+    } else {
+        fprintf(stderr, "A swarm can only use the random and randomi "
+                "algorithms\n");
+        return EXIT_FAILURE;
+    }
+    if (tile_component(maze, maze->start)
+            != tile_component(maze, maze->exit)) {
+        fprintf(stderr, "The exit is not connected to the start\n");
+        return EXIT_UNSOLVABLE;
+    }
+
+    fprintf(stderr, "seed %llu\n", (unsigned long long) ss.seed);
+    swarm_t *s = init_swarm(maze, swarm_size, avoid_back, ss.seed);
+    if (!s) {
+        fprintf(stderr, "Out of memory while creating the swarm\n");
+        return EXIT_FAILURE;
+    }
+
+    frames_t *f = NULL;
+    if (render) {
+        init_screen();
+        if (!(f = start_frames(maze, fps, maze->start))) {
+            fprintf(stderr, "Failed to start the render thread\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    double t = now_sec(), next = t;
+    long moves = 0;
+    uint32_t *occ;
+    while (s->tick < steps && s->nactive) {
+        moves += s->nactive;
+        swarm_tick(s);
+        if (!render)
+            continue;
+        if (frame_wanted(f) && (occ = frame_occupancy(f))) {
+            swarm_occupancy(s, occ);
+            frame_publish(f);
+        }
+        pace(&next);
+    }
+    if (render) {
+        stop_frames(f);
+        if ((occ = frame_occupancy(f))) {
+            swarm_occupancy(s, occ);
+            frame_publish(f);
+        }
+        draw_frame(f);
+        report_frames(f);
+        cleanup_frames(f);
+    }
+    t = now_sec() - t;
+    fprintf(stderr, "took %ld walker steps in %.3f ms (%.1f M steps/s)\n",
+            moves, t * 1e3, t > 0 ? moves / t / 1e6 : 0.0);
+
+    report_swarm(s);
+    cleanup_swarm(s);
     return EXIT_SUCCESS;
 }
 
+double step_period(void) {
+    return speed ? 1.0 / speed : delay * 1e-3;
+}
+
+void pace(double *next) {
+    double period = step_period();
+    if (!period)
+        return;
+    *next += period;
+    /* steps that are due within the same sleep are taken at once */
+    if (*next > now_sec())
+        sleep_until(*next);
+}
+
+frames_t* start_view(maze_t *maze, point_t focus, overview_t **ov) {
+    *ov = NULL;
+    if (overview) {
+        if (!(*ov = init_overview(maze))) {
+            fprintf(stderr, "Out of memory while building the overview\n");
+            return NULL;
+        }
+        overview_visit(*ov, focus);
+        rs_set_overview(*ov);
+        overview_keys();
+    }
+    frames_t *f = start_frames(maze, fps, focus);
+    if (!f) {
+        fprintf(stderr, "Failed to start the render thread\n");
+        rs_set_overview(NULL);
+        cleanup_overview(*ov);
+    }
+    return f;
+}
+
+void stop_view(frames_t *f, overview_t *ov, long idx) {
+    stop_frames(f);
+    frame_walker(f, idx);
+    draw_frame(f);
+    report_frames(f);
+    cleanup_frames(f);
+    rs_set_overview(NULL);
+    cleanup_overview(ov);
+}
+
+int export_image(maze_t *maze, trace_t *t, long steps) {
+    double s = now_sec();
+    if (!write_image(image, maze, t, steps, scale)) {
+        fprintf(stderr, "Failed to write the picture '%s'\n", image);
+        return 0;
+    }
+    fprintf(stderr, "wrote a %dx%d picture of step %ld to '%s' in %.3f s\n",
+            (maze->c + scale - 1) / scale, (maze->r + scale - 1) / scale,
+            steps, image, now_sec() - s);
+    return 1;
+}
+
+int run_replay(maze_t *maze) {
+    trace_t *t = trace_open(replay, maze);
+    if (!t) {
+        fprintf(stderr, "'%s' is not a trace of this maze\n", replay);
+        return EXIT_FAILURE;
+    }
+    fprintf(stderr, "replaying %ld steps of '%s', seed %llu\n", t->steps,
+            t->algo, (unsigned long long) t->seed);
+
+    trace_cursor_t c;
+    double s = now_sec();
+    int found = trace_seek(t, &c, from);
+    if (found <= 0) {
+        if (found < 0)
+            fprintf(stderr, "The trace does not match the maze\n");
+        else
+            fprintf(stderr, "The trace ends after %ld steps\n", t->steps);
+        trace_free(t);
+        return EXIT_FAILURE;
+    }
+    fprintf(stderr, "seeking to step %ld took %.3f ms\n", from,
+            (now_sec() - s) * 1e3);
+
+    walker_t *walker = init_walker(maze, algo->funct);
+    place_walker(maze, walker, c.idx);
+    if (!render) {
+        printf("step %ld at (%d, %d)\n", c.step, walker->pos.x,
+                walker->pos.y);
+        int ok = !image || export_image(maze, t, c.step);
+        cleanup_walker(walker);
+        trace_free(t);
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    init_screen();
+    overview_t *ov;
+    frames_t *f = start_view(maze, walker->pos, &ov);
+    if (!f)
+        return EXIT_FAILURE;
+    long end = from + steps < t->steps ? from + steps : t->steps;
+    double next = now_sec();
+    int match = 1;
+    while (c.step < end && (match = trace_next(t, &c))) {
+        if (ov) {
+            place_walker(maze, walker, c.idx);
+            overview_visit(ov, walker->pos);
+        }
+        if (frame_wanted(f))
+            frame_walker(f, c.idx);
+        pace(&next);
+    }
+    stop_view(f, ov, c.idx);
+    if (!match) {
+        fprintf(stderr, "The trace does not match the maze after step %ld\n",
+                c.step);
+        cleanup_walker(walker);
+        trace_free(t);
+        return EXIT_FAILURE;
+    }
+
+    place_walker(maze, walker, c.idx);
+    if (at_exit(maze, walker))
+        printf("Found exit after %ld steps\n", c.step);
+    else
+        printf("Replayed up to step %ld\n", c.step);
+    int ok = !image || export_image(maze, t, c.step);
+    cleanup_walker(walker);
+    trace_free(t);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void init_screen(void) {
+    if (sw || sh) {
+        rs_set_dimensions(sw ? sw : DEFAULT_WIDTH, sh ? sh : DEFAULT_HEIGHT);
+    } else {
+        rs_set_dimensions(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+        rs_detect_dim();
+    }
+    clear_term();
+}
+
 void usage(int err) {
     printf(
         "mazesolver, reads a maze from a file and tries solving it\n"
         "            shows the progress real-time\n"
         "\n"
-        "usage: mazesolver MAZE_FILE [-h|-v|-a ALGORITHM|-c|-d DELAY|-s STEPS"
-        "|-x WIDTH|-y HEIGHT|-n]\n\n"
+        "usage: mazesolver MAZE_FILE [-h|-v|-a ALGORITHM|-c|-d DELAY|-f FPS|-s STEPS"
+        "|-x WIDTH|-y HEIGHT|-n|-o|-b|-t THREADS|-r|-p|-l|-w WALKERS|-m TRIALS|--seed SEED"
+        "|--record FILE|--replay FILE|--from STEP|--speed STEPS"
+        "|--image FILE|--scale N]\n\n"
         "    -h             print the help page\n"
         "    -a ALGORITHM   set the algorithm to use\n"
         "    -c             use coloured output\n"
-        "    -d DELAY       sets the delay between frames in milliseconds\n"
+        "    -d DELAY       sets the delay between steps in milliseconds,\n"
+        "                   0 runs the solver at full speed\n"
+        "    -f FPS         sets the number of frames drawn per second\n"
         "    -s MAX_STEPS   sets the maximum steps the algorithm takes\n"
         "    -x WIDTH       sets the width of the screen\n"
         "    -y HEIGHT      sets the width of the screen\n"
         "    -n             enables no render mode\n"
+        "    -o             shows a zoomed out overview of the maze and the\n"
+        "                   trail of the walker, + - and 0 change the zoom\n"
+        "    -b             store the maze with one bit per tile\n"
+        "    -t THREADS     sets the number of threads solvers may use\n"
+        "    -r             check that the exit can be reached before solving\n"
+        "    -p             fill the dead ends of the maze before solving\n"
+        "    -l             label the connected parts of the maze before\n"
+        "                   solving, stops if the exit is not connected\n"
+        "    -w WALKERS     runs a swarm of random or randomi walkers at once\n"
+        "    -m, --trials TRIALS\n"
+        "                   runs TRIALS walks on all threads and reports the\n"
+        "                   distribution of their steps\n"
+        "    --seed SEED    sets the seed of the random walkers\n"
+        "    --record FILE  records the moves of the walker to FILE\n"
+        "    --replay FILE  plays the moves recorded in FILE back instead of\n"
+        "                   solving, -n prints the position at --from\n"
+        "    --from STEP    starts the replay at step STEP\n"
+        "    --speed STEPS  takes STEPS steps per second, overrides -d\n"
+        "    --image FILE   writes a picture of the maze and the walk to FILE,\n"
+        "                   a .ppm, .pgm or .png, at the step the walk or the\n"
+        "                   replay stopped\n"
+        "    --scale N      every pixel of the picture shows N * N tiles\n"
         );
 
     printf("\nThe following algorithms are available:\n");
     solver_usage("   - ");
     printf("\nSpecify a solver with the '-a' flag\n");
     printf("By default '%s' is used\n", DEFAULT_ALGO);
+    printf("\nExits with status %d when the solver proves it can not reach "
+            "the exit\n", EXIT_UNSOLVABLE);
     exit(err);
 }
 
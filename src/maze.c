@@ -9,23 +9,79 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "mazedef.h"
 #include "walkerdef.h"
+#include "timing.h"
 
 /* is set to 1 when a non-fatal error is generated by the maze parser */
 int mazewarn = 0;
 
-maze_t* init_maze(int r, int c) {
+/* classes of the characters that may appear inside a maze row */
+enum {
+    TC_INVALID = 0,
+    TC_TILE,
+    TC_START,
+    TC_EXIT,
+};
+
+static const unsigned char tile_class[256] = {
+    [(unsigned char) WALL] = TC_TILE,
+    [(unsigned char) OPEN] = TC_TILE,
+    [(unsigned char) START] = TC_START,
+    [(unsigned char) EXIT] = TC_EXIT,
+};
+
+maze_t* init_maze(int r, int c, int packed) {
     maze_t *m = (maze_t *)malloc(sizeof(maze_t));
+    if (!m)
+        return NULL;
     m->r = r;
     m->c = c;
     m->start.x = 0;
     m->start.y = 0;
+    m->exit.x = 0;
+    m->exit.y = 0;
 
-    m->maze = malloc(sizeof(char *) * r);
+    /*
+     * one sentinel column on each side, the stride is a multiple of a
+     * cache line (or of a word in the packed grid). The rows themselves
+     * start one tile past that boundary, after the west sentinel.
+     */
+    m->stride = (c + 2 + GRID_ALIGN - 1) & ~(long) (GRID_ALIGN - 1);
+    size_t size = (size_t) m->stride * (r + 2);
+    m->grid = m->cells = NULL;
+    m->bits = m->sbits = NULL;
+    m->bbase = m->stride + 1;
+    m->open = m->mgrid = NULL;
+    m->comp = NULL;
+    m->ncomp = 0;
 
-    for (int i = 0; i < r; i++)
-        m->maze[i] = malloc(sizeof(char) * c);
+    /* unfilled tiles and the sentinel ring are walls */
+    if (packed) {
+        size /= 8;
+        if (posix_memalign((void **) &m->bits, GRID_ALIGN, size)) {
+            free(m);
+            return NULL;
+        }
+        memset(m->bits, 0, size);
+    } else {
+        if (posix_memalign((void **) &m->grid, GRID_ALIGN, size)) {
+            free(m);
+            return NULL;
+        }
+        memset(m->grid, WALL, size);
+        m->cells = m->grid + m->stride + 1;
+    }
+
+    m->off[NORTH] = -m->stride;
+    m->off[EAST] = 1;
+    m->off[SOUTH] = m->stride;
+    m->off[WEST] = -1;
 
     return m;
 }
@@ -59,17 +115,78 @@ int parse_start(maze_t* m, int col, int row, char *c, int *start_defined) {
     }
 }
 
-maze_t* read_maze(const char *fname) {
-    FILE *f = fopen(fname, "r");
-    if (!f)
-        return NULL;
+/*
+ * Sets bit b of bits if t is not a wall, clears it otherwise
+ */
+static void put_bit(uint64_t *bits, unsigned long b, char t) {
+    if (t == WALL)
+        bits[b >> 6] &= ~(1ULL << (b & 63));
+    else
+        bits[b >> 6] |= 1ULL << (b & 63);
+}
+
+void set_tile(maze_t *m, point_t p, char t) {
+    long idx = maze_idx(m, p);
+    if (m->bits) {
+        put_bit(m->bits, idx + m->bbase, t);
+    } else {
+        m->cells[idx] = t;
+        if (m->sbits)
+            put_bit(m->sbits, idx + m->bbase, t);
+    }
+}
 
+/*
+ * Packs the l tiles of row into row number y of the packed grid bits,
+ * which is laid out like the packed grid of m
+ */
+static void pack_row(maze_t *m, uint64_t *bits, int y, const char *row,
+        int l) {
+    uint64_t *words = bits + (y + 1) * (m->stride / 64);
+    for (int x = 0; x < l; x++) {
+        /* column x is bit x + 1 of the row, bit 0 is the sentinel */
+        words[(x + 1) >> 6] |= (uint64_t) (row[x] != WALL) << ((x + 1) & 63);
+    }
+}
+
+/*
+ * Checks whether the tile c at (col, row) is allowed to be there.
+ * Prints a message and returns 0 when it is not.
+ */
+static int check_tile(maze_t *m, int col, int row, char c) {
+    if (!tile_class[(unsigned char) c]) {
+        fprintf(stderr, "Invalid character (%c) found at %i, %i\n", c,
+                row, col);
+        return 0;
+    }
+
+    /* check if all borders of the maze are walls */
+    if ((row == 0 || row == m->r - 1 || col == 0 || col == m->c - 1)
+            && c != WALL) {
+        fprintf(stderr, "Border is not a wall at %i, %i\n", col, row);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Reads a maze from a stream in blocks of BLOCK_SIZE.
+ * Used for files that can not be memory mapped, like pipes.
+ * The number of bytes read is stored in nbytes.
+ */
+static maze_t* read_maze_stream(FILE *f, int packed, size_t *nbytes) {
     /* get header info */
     int rows, columns;
-    fscanf(f, "%i,%i\n", &rows, &columns);
+    if (fscanf(f, "%i,%i\n", &rows, &columns) != 2 || rows <= 0
+            || columns <= 0) {
+        fprintf(stderr, "Invalid maze header\n");
+        return NULL;
+    }
     fprintf(stderr, "setting maze dimensions to: %i, %i\n", rows, columns);
 
-    maze_t *m = init_maze(rows, columns);
+    maze_t *m = init_maze(rows, columns, packed);
+    if (!m)
+        return NULL;
     char buffer[BLOCK_SIZE + 1];
 
     /* current column that is being filled */
@@ -82,7 +199,9 @@ maze_t* read_maze(const char *fname) {
     int start, exit;
     start = exit = 0;
 
+    *nbytes = 0;
     while ((l = fread(buffer, 1, BLOCK_SIZE, f))) {
+        *nbytes += l;
         /* buffer must be a string for debug output */
         buffer[l] = '\0';
         char *c = buffer;
@@ -101,18 +220,8 @@ maze_t* read_maze(const char *fname) {
                 goto fail;
             }
 
-            /* TODO */
-            if (!val_maze_char(*c)) {
-                fprintf(stderr, "Invalid character (%c) found at %i, %i\n", *c,
-                        cr, cc);
+            if (!check_tile(m, cc, cr, *c))
                 goto fail;
-            }
-
-            /* check if all borders of the maze are walls */
-            if ((cr == 0 || cr == m->c || cc == 0 || cc == m->c) && *c != WALL) {
-                fprintf(stderr, "Border is not a wall at %i, %i\n", cc, cr);
-                goto fail;
-            }
 
             /* parse special characters */
             switch (*c) {
@@ -127,56 +236,337 @@ maze_t* read_maze(const char *fname) {
                 break;
             }
             /* parse any other character */
-            m->maze[cr][cc] = *c;
+            set_tile(m, (point_t) {cc, cr}, *c);
             cc++;
         }
     }
     if (!start)
         goto fail;
-    fclose(f);
     return m;
 
 fail:
     /* a fatal error occured */
-    fclose(f);
     cleanup_maze(m);
     return NULL;
 }
 
+/*
+ * Reads a maze from a memory mapped file.
+ * Every row is copied from the mapping straight into the grid and then
+ * validated while it is still in cache. For the packed grid the row is
+ * copied to a scratch row and packed after validation.
+ * The mapping is released before returning.
+ */
+static maze_t* read_maze_map(int fd, size_t len, int packed) {
+    char *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    if (map == MAP_FAILED)
+        return NULL;
+    madvise(map, len, MADV_SEQUENTIAL);
+
+    /* get header info, the mapping is not nul terminated */
+    char header[64];
+    size_t hl = len < sizeof(header) - 1 ? len : sizeof(header) - 1;
+    memcpy(header, map, hl);
+    header[hl] = '\0';
+
+    maze_t *m = NULL;
+    char *scratch = NULL;
+    int rows, columns;
+    char *nl = memchr(map, '\n', hl);
+    if (!nl || sscanf(header, "%i,%i", &rows, &columns) != 2 || rows <= 0
+            || columns <= 0) {
+        fprintf(stderr, "Invalid maze header\n");
+        goto fail;
+    }
+    fprintf(stderr, "setting maze dimensions to: %i, %i\n", rows, columns);
+
+    m = init_maze(rows, columns, packed);
+    if (!m || (packed && !(scratch = malloc(columns))))
+        goto fail;
+
+    char *p = nl + 1;
+    char *end = map + len;
+    int start = 0;
+    int cr = 0;
+
+    while (p < end) {
+        nl = memchr(p, '\n', end - p);
+        char *le = nl ? nl : end;
+        int l = le - p;
+
+        if (l > 0 && (l > columns || cr >= rows)) {
+            fprintf(stderr, "Out of bounds (%i, %i). Maze dimensions %i, %i\n",
+                    l > columns ? columns : 0, cr, columns, rows);
+            goto fail;
+        }
+
+        char *row = m->cells ? m->cells + maze_idx(m, (point_t) {0, cr})
+            : scratch;
+        memcpy(row, p, l);
+
+        for (int cc = 0; cc < l; cc++) {
+            char *c = row + cc;
+            switch (tile_class[(unsigned char) *c]) {
+            case TC_TILE:
+                /* only the border needs a closer look */
+                if (cr != 0 && cr != rows - 1 && cc != 0 && cc != columns - 1)
+                    continue;
+                break;
+            case TC_START:
+                parse_start(m, cc, cr, c, &start);
+                break;
+            case TC_EXIT:
+                m->exit.x = cc;
+                m->exit.y = cr;
+                break;
+            }
+            if (!check_tile(m, cc, cr, *c))
+                goto fail;
+        }
+        if (m->bits)
+            pack_row(m, m->bits, cr, row, l);
+
+        cr++;
+        p = le + 1;
+    }
+
+    if (!start)
+        goto fail;
+    free(scratch);
+    munmap(map, len);
+    return m;
+
+fail:
+    /* a fatal error occured */
+    free(scratch);
+    munmap(map, len);
+    cleanup_maze(m);
+    return NULL;
+}
+
+maze_t* read_maze(const char *fname, int packed) {
+    int fd = open(fname, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    double t = now_sec();
+    maze_t *m = NULL;
+    size_t nbytes = 0;
+    const char *how;
+
+    /* map regular files, fall back to reading the stream for pipes */
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        nbytes = st.st_size;
+        m = read_maze_map(fd, nbytes, packed);
+        how = "mapped";
+        close(fd);
+    } else {
+        FILE *f = fdopen(fd, "r");
+        if (!f) {
+            close(fd);
+            return NULL;
+        }
+        m = read_maze_stream(f, packed, &nbytes);
+        how = "streamed";
+        fclose(f);
+    }
+
+    if (m) {
+        t = now_sec() - t;
+        double mb = nbytes / (1024.0 * 1024.0);
+        fprintf(stderr, "%s %.2f MB in %.3f ms (%.1f MB/s)\n", how, mb,
+                t * 1e3, t > 0 ? mb / t : 0.0);
+    }
+    return m;
+}
+
 int val_maze_char(char c) {
-    /* the valid maze characters */
-    static char valmazec[] = {
-        WALL,
-        START,
-        EXIT,
-        OPEN,
-        '\n',
-        EOF,
-        '\0',
-    };
-
-    char *check = valmazec;
-    while (check) {
-        if (c == *check)
-            return 1;
-        check++;
-    }
-    return 0;
+    /* the valid maze characters besides the tiles */
+    return tile_class[(unsigned char) c] || c == '\n' || c == EOF
+        || c == '\0';
+}
+
+char tile_at(maze_t *m, point_t p) {
+    if (!m->bits)
+        return m->cells[maze_idx(m, p)];
+
+    /* the packed grid only knows walls, the rest is stored separately */
+    if (!maze_bit(m, maze_idx(m, p)))
+        return WALL;
+    if (point_equals(&p, &m->start))
+        return START;
+    if (point_equals(&p, &m->exit))
+        return EXIT;
+    return OPEN;
 }
 
 char tile_dir(maze_t *m, point_t p, direction_t dir) {
+    if (!m->bits)
+        return maze_step_tile(m, maze_idx(m, p), dir);
+    if (!maze_step_open(m, maze_idx(m, p), dir))
+        return WALL;
     trans_point_dir(&p, dir);
+    return tile_at(m, p);
+}
+
+int build_open_masks(maze_t *m) {
+    /* the packed grid computes its masks from the bits */
+    if (!m || !m->cells)
+        return 0;
+    if (m->open)
+        return 1;
 
-    if (p.x < 0 || p.y < 0 || p.x >= m->c  || p.y >= m->r )
+    size_t size = (size_t) m->stride * (m->r + 2);
+    if (posix_memalign((void **) &m->mgrid, GRID_ALIGN, size))
         return 0;
-    return m->maze[p.y][p.x];
+    memset(m->mgrid, 0, size);
+    m->open = m->mgrid + m->stride + 1;
+
+    for (int y = 0; y < m->r; y++) {
+        const char *t = m->cells + maze_idx(m, (point_t) {0, y});
+        unsigned char *o = m->open + maze_idx(m, (point_t) {0, y});
+        for (int x = 0; x < m->c; x++) {
+            o[x] = (t[x - m->stride] != WALL) << NORTH
+                | (t[x + 1] != WALL) << EAST
+                | (t[x + m->stride] != WALL) << SOUTH
+                | (t[x - 1] != WALL) << WEST;
+        }
+        /* the sentinels are not maze walls */
+        o[0] |= 1 << WEST;
+        o[m->c - 1] |= 1 << EAST;
+        if (y == 0)
+            for (int x = 0; x < m->c; x++)
+                o[x] |= 1 << NORTH;
+        if (y == m->r - 1)
+            for (int x = 0; x < m->c; x++)
+                o[x] |= 1 << SOUTH;
+    }
+    return 1;
+}
+
+const uint64_t* maze_bits(maze_t *m) {
+    if (m->bits)
+        return m->bits;
+    if (m->sbits)
+        return m->sbits;
+
+    size_t size = (size_t) m->stride * (m->r + 2) / 8;
+    if (posix_memalign((void **) &m->sbits, GRID_ALIGN, size)) {
+        m->sbits = NULL;
+        return NULL;
+    }
+    memset(m->sbits, 0, size);
+    for (int y = 0; y < m->r; y++)
+        pack_row(m, m->sbits, y, m->cells + maze_idx(m, (point_t) {0, y}),
+                m->c);
+    return m->sbits;
+}
+
+int tile_mask(maze_t *m, point_t p) {
+    if (m->open)
+        return m->open[maze_idx(m, p)];
+
+    int mask = 0;
+    for (int dir = 0; dir < 4; dir++) {
+        point_t n = p;
+        trans_point_dir(&n, dir);
+        if (n.x < 0 || n.y < 0 || n.x >= m->c || n.y >= m->r
+                || tile_at(m, n) != WALL)
+            mask |= 1 << dir;
+    }
+    return mask;
+}
+
+/*
+ * Returns the number of tiles next to the tile with index idx that are
+ * not walls, the tiles off the maze do not count
+ */
+static int open_degree(const maze_t *m, long idx) {
+    int n = 0;
+    for (int dir = 0; dir < 4; dir++)
+        n += maze_step_open(m, idx, dir);
+    return n;
+}
+
+/*
+ * Turns the tile with index idx into a wall and updates the masks of its
+ * neighbours
+ */
+static void fill_tile(maze_t *m, long idx) {
+    if (m->bits) {
+        put_bit(m->bits, idx + m->bbase, WALL);
+        return;
+    }
+    m->cells[idx] = WALL;
+    if (m->sbits)
+        put_bit(m->sbits, idx + m->bbase, WALL);
+    if (m->open)
+        for (int dir = 0; dir < 4; dir++)
+            m->open[idx + m->off[dir]] &= ~(1 << (dir ^ 2));
+}
+
+long fill_dead_ends(maze_t *m, long *open_tiles) {
+    long start = maze_idx(m, m->start), exit = maze_idx(m, m->exit);
+    long size = 1024, n = 0, filled = 0, open = 0;
+    long *work = malloc(sizeof(long) * size);
+    if (!work)
+        return -1;
+
+    /* a tile is a dead end if at most one of its neighbours is open */
+    for (int y = 0; y < m->r; y++) {
+        for (int x = 0; x < m->c; x++) {
+            long idx = maze_idx(m, (point_t) {x, y});
+            if (!maze_open(m, idx))
+                continue;
+            open++;
+            if (idx == start || idx == exit || open_degree(m, idx) > 1)
+                continue;
+            if (n == size) {
+                long *t = realloc(work, sizeof(long) * (size *= 2));
+                if (!t) {
+                    free(work);
+                    return -1;
+                }
+                work = t;
+            }
+            work[n++] = idx;
+        }
+    }
+
+    /*
+     * Filling a dead end can turn its only open neighbour into a dead end,
+     * so follow the corridor until a junction is reached.
+     */
+    while (n) {
+        long idx = work[--n];
+        /* the corridor of an earlier dead end may have filled it already */
+        while (maze_open(m, idx) && idx != start && idx != exit
+                && open_degree(m, idx) <= 1) {
+            int mask = 0;
+            for (int dir = 0; dir < 4; dir++)
+                mask |= maze_step_open(m, idx, dir) << dir;
+            fill_tile(m, idx);
+            filled++;
+            if (!mask)
+                break;
+            idx += m->off[__builtin_ctz(mask)];
+        }
+    }
+    free(work);
+
+    if (open_tiles)
+        *open_tiles = open;
+    return filled;
 }
 
 void cleanup_maze(maze_t *maze) {
     if (maze) {
-        for(int i = 0; i < maze->r; i++)
-            free(maze->maze[i]);
-        free(maze->maze);
+        free(maze->grid);
+        free(maze->mgrid);
+        free(maze->bits);
+        free(maze->sbits);
+        free(maze->comp);
         free(maze);
     }
 }
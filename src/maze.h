@@ -9,9 +9,10 @@
 
 #ifndef MAZE_H
 #define MAZE_H
+#include <stdint.h>
 #include "point.h"
 
-/* size of blocks the maze file is read in */
+/* size of blocks a maze is read in when the file can not be mapped */
 #define BLOCK_SIZE 1024
 
 /* tile characters as found in maze */
@@ -25,14 +26,22 @@ typedef struct walker_t walker_t;
 
 /*
  * Initialized a maze with r rows and c columns
+ * All tiles are initialized as walls.
+ * If packed is 1 the maze is stored with one bit per tile instead of
+ * one byte per tile.
  *
  * Note: it is expected that the user frees the maze with cleanup_maze()
  */
-maze_t* init_maze(int r, int c);
+maze_t* init_maze(int r, int c, int packed);
 
 /*
  * Reads a maze from a file
  * fname is the path of the file that contains the maze
+ * packed is passed to init_maze()
+ *
+ * Regular files are memory mapped and copied row by row into the grid,
+ * other files (e.g. pipes) are read in blocks of BLOCK_SIZE. The load
+ * throughput is printed to stderr.
  *
  * When a fatal error is found in the file, the function prints a message 
  * and returns NULL. When an error occurs, mazewarn is set to one.
@@ -44,7 +53,7 @@ maze_t* init_maze(int r, int c);
  * A normal error occurs when:
  *     - A second entrance is found
  */
-maze_t* read_maze(const char *fname);
+maze_t* read_maze(const char *fname, int packed);
 
 /*
  * Returns 1 if c is a valid maze char,
@@ -52,6 +61,50 @@ maze_t* read_maze(const char *fname);
  */
 int val_maze_char(char c);
 
+/*
+ * Builds the open direction mask of every tile of m, a one time pass
+ * that should be done after the maze is read.
+ * Bit dir of the mask of a tile is set when the neighbouring tile in
+ * direction dir is not a wall. For tiles on the border the directions
+ * leading off the maze are set as well, so the inverted mask of a wall
+ * tells which walls it connects to.
+ *
+ * Packed mazes do not get a mask table, their masks are computed from
+ * the bits when needed.
+ *
+ * returns 1 if the table is built
+ * returns 0 otherwise
+ */
+int build_open_masks(maze_t *m);
+
+/*
+ * Returns the packed grid of m, see mazedef.h.
+ * For a maze stored with one byte per tile a packed copy is built on
+ * the first call and kept up to date by set_tile().
+ *
+ * returns NULL when out of memory
+ */
+const uint64_t* maze_bits(maze_t *m);
+
+/*
+ * Returns the open direction mask of the tile on point p,
+ * see build_open_masks()
+ */
+int tile_mask(maze_t *m, point_t p);
+
+/*
+ * Fills the dead ends of m with walls, repeatedly, until only the
+ * corridors that lead somewhere remain: the paths between the start and
+ * the exit, the loops and the corridors connecting them.
+ * The start and the exit are never filled.
+ * The number of tiles that were open before filling is stored in
+ * open_tiles when it is not NULL.
+ *
+ * returns the number of tiles filled
+ * returns -1 when out of memory
+ */
+long fill_dead_ends(maze_t *m, long *open_tiles);
+
 /*
  * Cleans up the maze pointed to by m
  * This functions should be called whenever a maze created with init_maze() is
@@ -59,8 +112,22 @@ int val_maze_char(char c);
  */
 void cleanup_maze(maze_t *m);
 
+/*
+ * Sets the tile on point p to t
+ * In a packed maze only the difference between WALL and other tiles
+ * is stored.
+ */
+void set_tile(maze_t *m, point_t p, char t);
+
+/*
+ * Returns the tile on point p
+ * p should lie inside the maze
+ */
+char tile_at(maze_t *m, point_t p);
+
 /*
  * Returns the tile found if one step in direction dir is taken from point p
+ * p should lie inside the maze, steps off the maze return WALL
  */
 char tile_dir(maze_t *m, point_t p, direction_t dir);
 
@@ -1,12 +1,127 @@
 #ifndef MAZEDEF_H
 #define MAZEDEF_H
+#include <stdint.h>
 #include "point.h"
 #include "maze.h"
+
+/*
+ * alignment of the tile grid in bytes,
+ * also the number of bits in a word of the packed grid
+ */
+#define GRID_ALIGN 64
+
 struct maze_t {
     int r, c;
-    char **maze;
+
+    /* number of tiles between two vertically adjacent tiles */
+    long stride;
+
+    /*
+     * The tiles, stored row after row in a single allocation.
+     * cells[maze_idx(m, p)] is the tile at p.
+     *
+     * The maze is surrounded by a ring of WALL sentinels, so
+     * cells[idx + off[dir]] can be read without bounds checks
+     * for every tile in the maze.
+     */
+    char *cells;
+
+    /* the (aligned) allocation cells points into */
+    char *grid;
+
+    /*
+     * The packed grid, used instead of cells when not NULL.
+     * One bit per tile, set when the tile is not a wall, with the same
+     * layout as grid: bit idx + bbase of bits is the tile with index idx.
+     * A row takes stride / 64 words and the sentinel ring is cleared.
+     */
+    uint64_t *bits;
+    long bbase;
+
+    /*
+     * A packed copy of the byte grid, built on demand by maze_bits() for
+     * algorithms that scan rows a word at a time. Laid out like bits.
+     */
+    uint64_t *sbits;
+
+    /*
+     * The open direction masks, see build_open_masks().
+     * Indexed like cells, NULL when not built.
+     */
+    unsigned char *open;
+    /* the allocation open points into */
+    unsigned char *mgrid;
+
+    /*
+     * The connected component of every open tile, see label_components().
+     * Indexed like cells, NULL when not labelled.
+     */
+    uint32_t *comp;
+    /* the number of components */
+    long ncomp;
+
+    /* index offset of a single step in a direction, indexed by direction */
+    long off[4];
+
     point_t start;
     point_t exit;
 };
 
+/*
+ * Returns the index of point p in m->cells
+ */
+static inline long maze_idx(const maze_t *m, point_t p) {
+    return (long) p.y * m->stride + p.x;
+}
+
+/*
+ * Returns 1 if the tile with index idx in m->bits is not a wall
+ */
+static inline int maze_bit(const maze_t *m, long idx) {
+    unsigned long b = idx + m->bbase;
+    return (m->bits[b >> 6] >> (b & 63)) & 1;
+}
+
+/*
+ * Returns 1 if the tile with index idx is not a wall,
+ * works for both the byte and the packed grid.
+ */
+static inline int maze_open(const maze_t *m, long idx) {
+    if (m->bits)
+        return maze_bit(m, idx);
+    return m->cells[idx] != WALL;
+}
+
+/*
+ * Returns the tile next to the tile with index idx in direction dir
+ * Only valid for the byte grid.
+ */
+static inline char maze_step_tile(const maze_t *m, long idx, direction_t dir) {
+    return m->cells[idx + m->off[dir]];
+}
+
+/*
+ * Returns 1 if the tile next to the tile with index idx in direction dir
+ * is not a wall, works for both the byte and the packed grid.
+ */
+static inline int maze_step_open(const maze_t *m, long idx, direction_t dir) {
+    if (m->bits)
+        return maze_bit(m, idx + m->off[dir]);
+    return maze_step_tile(m, idx, dir) != WALL;
+}
+
+/*
+ * Returns the directions a walker on the tile with index idx can move in
+ * as a mask, bit dir is set if direction dir is not blocked by a wall.
+ */
+static inline int maze_open_mask(const maze_t *m, long idx) {
+    if (m->open)
+        return m->open[idx];
+
+    int mask = 0;
+    for (int dir = 0; dir < 4; dir++)
+        mask |= maze_step_open(m, idx, dir) << dir;
+    return mask;
+}
+
 #endif /* MAZEDEF_H */
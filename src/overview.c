@@ -0,0 +1,341 @@
+/*
+ * Overview renderer
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <termios.h>
+#include "mazedef.h"
+#include "walkerdef.h"
+#include "overview.h"
+
+/* the bit of every dot of a braille character, indexed by [y][x] */
+static const uint8_t dot_bit[4][2] = {
+    {0x01, 0x08},
+    {0x02, 0x10},
+    {0x04, 0x20},
+    {0x40, 0x80},
+};
+
+/*
+ * the wall density a dot needs to be set, indexed by [y][x]. The
+ * thresholds are dithered over the dots of a character, so blocks that are
+ * half wall show half of their dots instead of all or none.
+ */
+static const uint8_t dot_threshold[4][2] = {
+    {16, 144},
+    {208, 80},
+    {48, 176},
+    {240, 112},
+};
+
+/* a character takes at most a cursor move, a colour and a glyph */
+#define CHAR_BYTES 16
+
+/* the frame is composed in out, see render_overview() */
+static char *out;
+static size_t out_size;
+
+/* the terminal settings to restore at exit, see overview_keys() */
+static struct termios saved_term;
+static int keys;
+/* the handlers of the signals that restore the terminal */
+static struct sigaction saved_int, saved_term_sig;
+
+static void restore_keys(void);
+
+void cleanup_overview(overview_t *o) {
+    restore_keys();
+    if (!o)
+        return;
+    for (int l = 0; l < o->levels; l++) {
+        if (o->wall)
+            free(o->wall[l]);
+        if (o->trail)
+            free(o->trail[l]);
+    }
+    free(o->wall);
+    free(o->trail);
+    free(o->lw);
+    free(o->lh);
+    free(o);
+}
+
+/* the number of walls in the block of 2^l * 2^l tiles at bx, by */
+static long block_walls(maze_t *m, int l, long bx, long by, long *tiles) {
+    long x0 = bx << l, y0 = by << l, walls = 0;
+    long x1 = x0 + (1L << l), y1 = y0 + (1L << l);
+    if (x1 > m->c)
+        x1 = m->c;
+    if (y1 > m->r)
+        y1 = m->r;
+    for (long y = y0; y < y1; y++) {
+        long idx = maze_idx(m, (point_t) {x0, y});
+        for (long x = x0; x < x1; x++, idx++)
+            walls += !maze_open(m, idx);
+    }
+    *tiles = (x1 - x0) * (y1 - y0);
+    return walls;
+}
+
+overview_t* init_overview(maze_t *m) {
+    overview_t *o = calloc(1, sizeof(overview_t));
+    if (!o)
+        return NULL;
+    o->m = m;
+    o->zoom = -1;
+
+    /* level l has blocks of 2^l tiles, the last level is a single block */
+    long size = m->r > m->c ? m->r : m->c;
+    o->levels = 1;
+    while ((1L << (o->levels - 1)) < size)
+        o->levels++;
+    if (o->levels <= OV_BASE)
+        o->levels = OV_BASE + 1;
+
+    o->lw = malloc(sizeof(long) * o->levels);
+    o->lh = malloc(sizeof(long) * o->levels);
+    o->wall = calloc(o->levels, sizeof(uint8_t *));
+    o->trail = calloc(o->levels, sizeof(uint64_t *));
+    if (!o->lw || !o->lh || !o->wall || !o->trail) {
+        cleanup_overview(o);
+        return NULL;
+    }
+
+    for (int l = 0; l < o->levels; l++) {
+        o->lw[l] = (m->c + (1L << l) - 1) >> l;
+        o->lh[l] = (m->r + (1L << l) - 1) >> l;
+        size_t blocks = (size_t) o->lw[l] * o->lh[l];
+        if (!(o->trail[l] = calloc((blocks + 63) / 64, sizeof(uint64_t)))) {
+            cleanup_overview(o);
+            return NULL;
+        }
+        if (l >= OV_BASE && !(o->wall[l] = malloc(blocks))) {
+            cleanup_overview(o);
+            return NULL;
+        }
+    }
+
+    /* the base level is counted from the maze */
+    for (long by = 0; by < o->lh[OV_BASE]; by++) {
+        uint8_t *row = o->wall[OV_BASE] + by * o->lw[OV_BASE];
+        for (long bx = 0; bx < o->lw[OV_BASE]; bx++) {
+            long tiles, walls = block_walls(m, OV_BASE, bx, by, &tiles);
+            row[bx] = walls * 255 / tiles;
+        }
+    }
+    /* every other level averages 2 * 2 blocks of the level below */
+    for (int l = OV_BASE + 1; l < o->levels; l++) {
+        const uint8_t *below = o->wall[l - 1];
+        long bw = o->lw[l - 1], bh = o->lh[l - 1];
+        for (long by = 0; by < o->lh[l]; by++) {
+            for (long bx = 0; bx < o->lw[l]; bx++) {
+                int sum = 0, n = 0;
+                for (long y = 2 * by; y < 2 * by + 2 && y < bh; y++) {
+                    for (long x = 2 * bx; x < 2 * bx + 2 && x < bw; x++) {
+                        sum += below[y * bw + x];
+                        n++;
+                    }
+                }
+                o->wall[l][by * o->lw[l] + bx] = sum / n;
+            }
+        }
+    }
+    return o;
+}
+
+void overview_visit(overview_t *o, point_t p) {
+    for (int l = 0; l < o->levels; l++) {
+        long b = (p.y >> l) * o->lw[l] + (p.x >> l);
+        uint64_t bit = 1ULL << (b & 63), *word = &o->trail[l][b >> 6];
+        /* the blocks above a visited block are visited too */
+        if (__atomic_load_n(word, __ATOMIC_RELAXED) & bit)
+            return;
+        __atomic_fetch_or(word, bit, __ATOMIC_RELAXED);
+    }
+}
+
+/* what a dot shows */
+enum { DOT_NONE, DOT_WALL, DOT_TRAIL };
+
+/*
+ * returns what the dot of block bx, by of level l shows, a wall when the
+ * wall density of the block reaches threshold
+ */
+static int dot(overview_t *o, int l, long bx, long by, int threshold) {
+    if (bx >= o->lw[l] || by >= o->lh[l])
+        return DOT_NONE;
+    long b = by * o->lw[l] + bx;
+    if (__atomic_load_n(&o->trail[l][b >> 6], __ATOMIC_RELAXED)
+            & (1ULL << (b & 63)))
+        return DOT_TRAIL;
+    long density;
+    if (l >= OV_BASE) {
+        density = o->wall[l][b];
+    } else {
+        long tiles, walls = block_walls(o->m, l, bx, by, &tiles);
+        density = walls * 255 / tiles;
+    }
+    return density >= threshold ? DOT_WALL : DOT_NONE;
+}
+
+/* returns the first block of a level of n blocks that shows f, centred */
+static long first_block(long f, long n, long shown) {
+    long b = f - shown / 2;
+    if (b > n - shown)
+        b = n - shown;
+    return b < 0 ? 0 : b;
+}
+
+/* applies the keys that were pressed since the last frame */
+static void read_keys(overview_t *o, int fit) {
+    struct pollfd p = {STDIN_FILENO, POLLIN, 0};
+    char c;
+    while (keys && poll(&p, 1, 0) > 0 && read(STDIN_FILENO, &c, 1) == 1) {
+        if (o->zoom < 0)
+            o->zoom = fit;
+        if ((c == '+' || c == '=') && o->zoom > 0)
+            o->zoom--;
+        else if (c == '-' && o->zoom < o->levels - 1)
+            o->zoom++;
+        else if (c == '0')
+            o->zoom = -1;
+    }
+}
+
+int render_overview(overview_t *o, walker_t *w, const ren_state_t *s) {
+    if (!s->focus)
+        return MRERR_NOFOCUS;
+
+    maze_t *m = o->m;
+    /* the last row shows the zoom level */
+    int cw = s->w, ch = s->h > 1 ? s->h - 1 : 1;
+    long dw = 2L * cw, dh = 4L * ch;
+
+    int fit = 0;
+    while (fit < o->levels - 1 && (o->lw[fit] > dw || o->lh[fit] > dh))
+        fit++;
+    read_keys(o, fit);
+    int l = o->zoom < 0 ? fit : o->zoom;
+
+    size_t need = (size_t) cw * ch * CHAR_BYTES + (size_t) ch + 128;
+    if (need > out_size) {
+        char *b = realloc(out, need);
+        if (!b)
+            return MRERR_NOMEM;
+        out = b;
+        out_size = need;
+    }
+
+    long bx0 = first_block(s->focus->x >> l, o->lw[l], dw);
+    long by0 = first_block(s->focus->y >> l, o->lh[l], dh);
+    /* the characters that show a letter instead of dots */
+    point_t marks[3] = {m->start, m->exit, w ? w->pos : m->start};
+    const char *mark_glyph[3] = {MR_START, MR_EXIT, MR_WALKER};
+    const char *mark_col[3] = {CGRN, CRED, CBLU};
+
+    char *p = stpcpy(out, SQ_GOTO_1_1);
+    /* 1 = the characters are coloured as trail */
+    int trail_col = 0;
+    for (int cy = 0; cy < ch; cy++) {
+        for (int cx = 0; cx < cw; cx++) {
+            long bx = bx0 + 2L * cx, by = by0 + 4L * cy;
+            int mark = -1;
+            for (int i = w ? 2 : 1; i >= 0; i--) {
+                if ((marks[i].x >> l) - bx >= 0 && (marks[i].x >> l) - bx < 2
+                        && (marks[i].y >> l) - by >= 0
+                        && (marks[i].y >> l) - by < 4) {
+                    mark = i;
+                    break;
+                }
+            }
+            if (mark >= 0) {
+                if (s->coloured)
+                    p = stpcpy(stpcpy(stpcpy(p, mark_col[mark]),
+                                mark_glyph[mark]), CNRM);
+                else
+                    p = stpcpy(p, mark_glyph[mark]);
+                trail_col = 0;
+                continue;
+            }
+
+            int bits = 0, trail = 0, d;
+            for (int y = 0; y < 4; y++) {
+                for (int x = 0; x < 2; x++) {
+                    if ((d = dot(o, l, bx + x, by + y,
+                                    dot_threshold[y][x])) != DOT_NONE)
+                        bits |= dot_bit[y][x];
+                    trail |= d == DOT_TRAIL;
+                }
+            }
+            /* the colour only changes between a trail and the rest */
+            if (s->coloured && trail != trail_col) {
+                p = stpcpy(p, trail ? CYEL : CNRM);
+                trail_col = trail;
+            }
+            /* U+2800 + bits in UTF-8 */
+            *p++ = (char) 0xe2;
+            *p++ = (char) (0xa0 | bits >> 6);
+            *p++ = (char) (0x80 | (bits & 0x3f));
+        }
+        *p++ = '\n';
+    }
+    if (trail_col)
+        p = stpcpy(p, CNRM);
+    p += sprintf(p, "\033[Kzoom 1:%ld, %ldx%ld blocks%s\n", 1L << l,
+            o->lw[l], o->lh[l], keys ? ", + - and 0 change the zoom" : "");
+
+    if (!write_frame(out, p - out))
+        return MRERR_WRITE;
+    return MRSUCC;
+}
+
+static void restore_keys(void) {
+    if (!keys)
+        return;
+    tcsetattr(STDIN_FILENO, TCSANOW, &saved_term);
+    sigaction(SIGINT, &saved_int, NULL);
+    sigaction(SIGTERM, &saved_term_sig, NULL);
+    keys = 0;
+}
+
+/*
+ * restores the terminal when the program is interrupted, then lets the
+ * signal end it as it would have
+ */
+static void restore_on_signal(int sig) {
+    tcsetattr(STDIN_FILENO, TCSANOW, &saved_term);
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+void overview_keys(void) {
+    static int registered;
+    if (keys || !isatty(STDIN_FILENO)
+            || tcgetattr(STDIN_FILENO, &saved_term))
+        return;
+    struct termios t = saved_term;
+    t.c_lflag &= ~(ICANON | ECHO);
+    t.c_cc[VMIN] = 0;
+    t.c_cc[VTIME] = 0;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = restore_on_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &saved_int);
+    sigaction(SIGTERM, &sa, &saved_term_sig);
+    if (tcsetattr(STDIN_FILENO, TCSANOW, &t)) {
+        sigaction(SIGINT, &saved_int, NULL);
+        sigaction(SIGTERM, &saved_term_sig, NULL);
+        return;
+    }
+    if (!registered)
+        atexit(restore_keys);
+    registered = 1;
+    keys = 1;
+}
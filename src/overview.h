@@ -0,0 +1,85 @@
+/*
+ * Overview renderer
+ *
+ * Shows a zoomed out view of mazes far larger than the terminal with
+ * braille characters, every character holds 2 * 4 dots. At zoom level z
+ * a dot stands for a block of 2^z * 2^z tiles and is set when most of the
+ * block is wall or when the walker visited a tile in it.
+ *
+ * The wall density of the blocks is kept in a pyramid of levels, each
+ * level halves the width and the height of the one below, so a frame
+ * reads a fixed number of blocks whatever the size of the maze. The trail
+ * of the walker is kept in a pyramid of bits that is updated on every
+ * step, a step on a visited tile only reads one bit.
+ */
+
+#ifndef OVERVIEW_H
+#define OVERVIEW_H
+
+#include <stdint.h>
+#include "point.h"
+#include "maze.h"
+#include "walker.h"
+#include "renderer.h"
+
+/*
+ * The first level of the wall pyramid, the blocks of the levels below
+ * are counted from the maze itself
+ */
+#define OV_BASE 2
+
+struct overview_t {
+    maze_t *m;
+
+    /* the number of levels, the last level is a single block */
+    int levels;
+    /* the width and height of every level in blocks */
+    long *lw, *lh;
+
+    /*
+     * the wall density of every block of the levels from OV_BASE, 0 for
+     * no walls to 255 for only walls, NULL below OV_BASE
+     */
+    uint8_t **wall;
+    /* the blocks with a visited tile of every level, one bit per block */
+    uint64_t **trail;
+
+    /* the zoom level that is shown, -1 = the level that fits the maze */
+    int zoom;
+};
+
+/*
+ * Builds the wall pyramid of m
+ *
+ * returns the overview on success
+ * returns NULL when out of memory
+ */
+overview_t* init_overview(maze_t *m);
+
+/*
+ * Marks tile p visited by the walker.
+ * May be called by the simulation while another thread renders
+ */
+void overview_visit(overview_t *o, point_t p);
+
+/*
+ * Renders the overview of the maze around the focus of s, see
+ * render_maze()
+ */
+int render_overview(overview_t *o, walker_t *w, const ren_state_t *s);
+
+/*
+ * Lets the keys + and - change the zoom level and 0 fit the maze on the
+ * screen, when stdin is a terminal. Switches the terminal to reading
+ * single key presses until cleanup_overview(), the program exits or it
+ * is ended by SIGINT or SIGTERM.
+ */
+void overview_keys(void);
+
+/*
+ * Frees an overview made by init_overview() and restores the terminal
+ * changed by overview_keys()
+ */
+void cleanup_overview(overview_t *o);
+
+#endif /* OVERVIEW_H */
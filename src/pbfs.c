@@ -0,0 +1,388 @@
+/*
+ * Parallel direction optimizing breadth first search
+ *
+ * A level synchronous search. Levels with a small frontier are expanded
+ * top-down: the threads split the frontier list and claim the neighbours
+ * with atomic bitset operations. Levels with a large frontier are
+ * expanded bottom-up: the threads split the grid and test whole words of
+ * unvisited open tiles against the frontier bitset at once.
+ *
+ * All bitsets and the parent directions are indexed by bit position in
+ * the packed grid (tile index + bbase), so they line up with maze_bits().
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "mazedef.h"
+#include "walkerdef.h"
+#include "search.h"
+#include "solvers.h"
+#include "timing.h"
+
+/* go bottom-up when the frontier exceeds 1 / ALPHA of the unvisited tiles */
+#define PBFS_ALPHA 14
+/* go back top-down when the frontier drops below 1 / BETA of the tiles */
+#define PBFS_BETA 24
+
+enum {
+    TOP_DOWN,
+    BOTTOM_UP,
+};
+
+/*
+ * The state of a parallel search shared by all threads
+ */
+typedef struct pbfs_t {
+    maze_t *m;
+    /* the packed grid */
+    const uint64_t *open;
+    /* the words of the packed grid that hold maze rows */
+    long w0, w1;
+
+    uint64_t *visited;
+    uint8_t *parents;
+
+    /* the frontier as list (top-down) or bitset (bottom-up) */
+    long *list;
+    size_t nlist, caplist;
+    uint64_t *front, *next;
+
+    /* the per thread results of a level */
+    long **local;
+    size_t *nlocal, *caplocal;
+
+    int nthreads;
+    /* set once all threads are started and nthreads is final */
+    int ready;
+    pthread_barrier_t bar;
+    int mode;
+    /*
+     * 1 when the search is over, -1 when out of memory. Workers may set it
+     * at the same time, so it is only accessed atomically.
+     */
+    int done;
+} pbfs_t;
+
+typedef struct pbfs_arg_t {
+    pbfs_t *s;
+    int id;
+} pbfs_arg_t;
+
+/*
+ * The state of the walker, path must stay the first member
+ */
+typedef struct pbfs_path_t {
+    path_t path;
+    int threads;
+    long levels, bottom_up;
+} pbfs_path_t;
+
+static int local_push(pbfs_t *s, int id, long b) {
+    if (s->nlocal[id] == s->caplocal[id]) {
+        size_t cap = s->caplocal[id] ? s->caplocal[id] * 2 : 1024;
+        long *buf = realloc(s->local[id], sizeof(long) * cap);
+        if (!buf)
+            return 0;
+        s->local[id] = buf;
+        s->caplocal[id] = cap;
+    }
+    s->local[id][s->nlocal[id]++] = b;
+    return 1;
+}
+
+/*
+ * Expands the part of the frontier list of thread id
+ */
+static void top_down(pbfs_t *s, int id) {
+    maze_t *m = s->m;
+    size_t lo = s->nlist * id / s->nthreads;
+    size_t hi = s->nlist * (id + 1) / s->nthreads;
+
+    for (size_t i = lo; i < hi; i++) {
+        long b = s->list[i];
+        int mask = maze_open_mask(m, b - m->bbase);
+        for (int dir = 0; dir < 4; dir++) {
+            if (!((mask >> dir) & 1))
+                continue;
+            long n = b + m->off[dir];
+            uint64_t bit = 1ULL << (n & 63);
+            if (__atomic_load_n(&s->visited[n >> 6], __ATOMIC_RELAXED) & bit)
+                continue;
+            /* only the thread that sets the bit claims the tile */
+            if (__atomic_fetch_or(&s->visited[n >> 6], bit, __ATOMIC_RELAXED)
+                    & bit)
+                continue;
+            __atomic_fetch_or(&s->parents[n >> 2], dir << ((n & 3) * 2),
+                    __ATOMIC_RELAXED);
+            if (!local_push(s, id, n))
+                __atomic_store_n(&s->done, -1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/*
+ * Scans the part of the grid of thread id for unvisited open tiles
+ * next to the frontier. Every thread owns a range of words, so no
+ * atomic operations are needed.
+ */
+static void bottom_up(pbfs_t *s, int id) {
+    maze_t *m = s->m;
+    long words = m->stride / 64;
+    long n = s->w1 - s->w0;
+    long lo = s->w0 + n * id / s->nthreads;
+    long hi = s->w0 + n * (id + 1) / s->nthreads;
+    const uint64_t *f = s->front;
+    long count = 0;
+
+    for (long k = lo; k < hi; k++) {
+        uint64_t cand = s->open[k] & ~s->visited[k];
+        if (!cand)
+            continue;
+        uint64_t near = f[k] << 1 | f[k - 1] >> 63 | f[k] >> 1
+            | f[k + 1] << 63 | f[k - words] | f[k + words];
+        uint64_t found = cand & near;
+        if (!found)
+            continue;
+
+        s->visited[k] |= found;
+        s->next[k] |= found;
+        while (found) {
+            long b = (k << 6) + __builtin_ctzll(found);
+            found &= found - 1;
+            count++;
+            for (int dir = 0; dir < 4; dir++) {
+                long p = b - m->off[dir];
+                if ((f[p >> 6] >> (p & 63)) & 1) {
+                    set_dir2(s->parents, b, dir);
+                    break;
+                }
+            }
+        }
+    }
+    s->nlocal[id] = count;
+}
+
+static void* pbfs_thread(void *arg) {
+    pbfs_arg_t *a = arg;
+    pbfs_t *s = a->s;
+    while (!__atomic_load_n(&s->ready, __ATOMIC_ACQUIRE))
+        sched_yield();
+    for (;;) {
+        pthread_barrier_wait(&s->bar);
+        if (__atomic_load_n(&s->done, __ATOMIC_RELAXED))
+            break;
+        if (s->mode == TOP_DOWN)
+            top_down(s, a->id);
+        else
+            bottom_up(s, a->id);
+        pthread_barrier_wait(&s->bar);
+    }
+    return NULL;
+}
+
+/*
+ * Moves the frontier of the last level in place for the next level and
+ * switches direction when needed. Run by a single thread between levels.
+ *
+ * returns the size of the new frontier
+ */
+static size_t next_level(pbfs_t *s, long unvisited, long total) {
+    size_t size = 0;
+
+    if (s->mode == TOP_DOWN) {
+        for (int t = 0; t < s->nthreads; t++)
+            size += s->nlocal[t];
+        if (size > s->caplist) {
+            long *list = realloc(s->list, sizeof(long) * size);
+            if (!list) {
+                __atomic_store_n(&s->done, -1, __ATOMIC_RELAXED);
+                return 0;
+            }
+            s->list = list;
+            s->caplist = size;
+        }
+        s->nlist = 0;
+        for (int t = 0; t < s->nthreads; t++) {
+            if (s->nlocal[t])
+                memcpy(s->list + s->nlist, s->local[t],
+                        sizeof(long) * s->nlocal[t]);
+            s->nlist += s->nlocal[t];
+            s->nlocal[t] = 0;
+        }
+
+        if (size > (size_t) unvisited / PBFS_ALPHA) {
+            memset(s->front + s->w0, 0, sizeof(uint64_t) * (s->w1 - s->w0));
+            for (size_t i = 0; i < s->nlist; i++)
+                bit_set(s->front, s->list[i]);
+            s->mode = BOTTOM_UP;
+        }
+    } else {
+        for (int t = 0; t < s->nthreads; t++) {
+            size += s->nlocal[t];
+            s->nlocal[t] = 0;
+        }
+        uint64_t *f = s->front;
+        s->front = s->next;
+        s->next = f;
+        memset(s->next + s->w0, 0, sizeof(uint64_t) * (s->w1 - s->w0));
+
+        if (size < (size_t) total / PBFS_BETA) {
+            if (size > s->caplist) {
+                long *list = realloc(s->list, sizeof(long) * size);
+                if (!list) {
+                    __atomic_store_n(&s->done, -1, __ATOMIC_RELAXED);
+                    return 0;
+                }
+                s->list = list;
+                s->caplist = size;
+            }
+            s->nlist = 0;
+            for (long k = s->w0; k < s->w1; k++) {
+                for (uint64_t w = s->front[k]; w; w &= w - 1)
+                    s->list[s->nlist++] = (k << 6) + __builtin_ctzll(w);
+            }
+            s->mode = TOP_DOWN;
+        }
+    }
+    return size;
+}
+
+int init_pbfs(maze_t *m, walker_t *w) {
+    if (w->state != NULL)
+        return 0;
+
+    double t = now_sec();
+    pbfs_t s;
+    memset(&s, 0, sizeof(s));
+    s.m = m;
+    s.open = maze_bits(m);
+    s.nthreads = ss.threads;
+    s.w0 = m->stride / 64;
+    s.w1 = (m->r + 1) * (m->stride / 64);
+
+    /* one word of padding on either side for the bottom-up shifts */
+    long words = (m->r + 2) * (m->stride / 64);
+    s.visited = calloc(words, sizeof(uint64_t));
+    s.parents = calloc(words * 16, 1);
+    uint64_t *front = calloc(words + 2, sizeof(uint64_t));
+    uint64_t *next = calloc(words + 2, sizeof(uint64_t));
+    s.front = front ? front + 1 : NULL;
+    s.next = next ? next + 1 : NULL;
+    s.local = calloc(s.nthreads, sizeof(long *));
+    s.nlocal = calloc(s.nthreads, sizeof(size_t));
+    s.caplocal = calloc(s.nthreads, sizeof(size_t));
+    s.caplist = 1;
+    s.list = malloc(sizeof(long));
+    pthread_t *th = calloc(s.nthreads, sizeof(pthread_t));
+    pbfs_arg_t *args = calloc(s.nthreads, sizeof(pbfs_arg_t));
+    pbfs_path_t *pp = NULL;
+    int ok = s.open && s.visited && s.parents && s.front && s.next && s.local
+        && s.nlocal && s.caplocal && s.list && th && args;
+    int started = 0;
+    if (!ok)
+        goto out;
+
+    /* count the open tiles */
+    long total = 0;
+    for (long k = s.w0; k < s.w1; k++)
+        total += __builtin_popcountll(s.open[k]);
+
+    long from = maze_idx(m, m->start) + m->bbase;
+    long to = maze_idx(m, m->exit) + m->bbase;
+    bit_set(s.visited, from);
+    s.list[s.nlist++] = from;
+    long unvisited = total - 1;
+    long levels = 0, bu = 0;
+
+    for (int i = 1; i < s.nthreads; i++) {
+        args[i].s = &s;
+        args[i].id = i;
+        if (pthread_create(&th[i], NULL, pbfs_thread, &args[i]))
+            break;
+        started++;
+    }
+    if (started != s.nthreads - 1)
+        fprintf(stderr, "pbfs: could only start %i threads\n", started + 1);
+    s.nthreads = started + 1;
+    pthread_barrier_init(&s.bar, NULL, s.nthreads);
+    __atomic_store_n(&s.ready, 1, __ATOMIC_RELEASE);
+
+    size_t size = 1;
+    while (!bit_test(s.visited, to) && size
+            && __atomic_load_n(&s.done, __ATOMIC_RELAXED) == 0) {
+        pthread_barrier_wait(&s.bar);
+        if (s.mode == TOP_DOWN)
+            top_down(&s, 0);
+        else
+            bottom_up(&s, 0);
+        pthread_barrier_wait(&s.bar);
+
+        levels++;
+        bu += s.mode == BOTTOM_UP;
+        size = next_level(&s, unvisited, total);
+        unvisited -= size;
+    }
+
+    /* release the workers */
+    int failed = __atomic_load_n(&s.done, __ATOMIC_RELAXED) < 0;
+    __atomic_store_n(&s.done, 1, __ATOMIC_RELAXED);
+    pthread_barrier_wait(&s.bar);
+    for (int i = 1; i <= started; i++)
+        pthread_join(th[i], NULL);
+    pthread_barrier_destroy(&s.bar);
+
+    if (failed) {
+        ok = 0;
+        goto out;
+    }
+    if (!bit_test(s.visited, to)) {
+        fprintf(stderr, "pbfs: the exit can not be reached from the start\n");
+        ok = INIT_UNREACHABLE;
+        goto out;
+    }
+
+    /* the parents are indexed by bit position, which trace_path allows */
+    path_t *p = trace_path(m, s.parents, from, to);
+    ok = p != NULL && (pp = realloc(p, sizeof(pbfs_path_t))) != NULL;
+    if (!ok) {
+        if (p)
+            free_path(p);
+        goto out;
+    }
+    pp->path.expanded = total - unvisited;
+    pp->path.time = now_sec() - t;
+    pp->threads = s.nthreads;
+    pp->levels = levels;
+    pp->bottom_up = bu;
+    w->state = pp;
+
+out:
+    /* s.front and s.next point one word into these and may be swapped */
+    free(front);
+    free(next);
+    if (s.local)
+        for (int i = 0; i < s.nthreads; i++)
+            free(s.local[i]);
+    free(s.local);
+    free(s.nlocal);
+    free(s.caplocal);
+    free(s.list);
+    free(s.visited);
+    free(s.parents);
+    free(th);
+    free(args);
+    return ok;
+}
+
+void report_pbfs(void *state) {
+    pbfs_path_t *pp = state;
+    if (!pp)
+        return;
+    report_path(state);
+    printf("%i threads, %ld levels (%ld bottom-up), %.1f M tiles/s\n",
+            pp->threads, pp->levels, pp->bottom_up,
+            pp->path.time > 0 ? pp->path.expanded / pp->path.time * 1e-6 : 0);
+}
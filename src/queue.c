@@ -0,0 +1,88 @@
+/*
+ * Queues of tile indices used by the search solvers
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "queue.h"
+
+/* initial capacity of a queue, must be a power of two */
+#define QUEUE_INIT 4096
+
+int queue_init(queue_t *q) {
+    q->cap = QUEUE_INIT;
+    q->head = q->len = 0;
+    q->buf = malloc(sizeof(long) * q->cap);
+    return q->buf != NULL;
+}
+
+int queue_push(queue_t *q, long idx) {
+    if (q->len == q->cap) {
+        /* grow and unwrap the ring */
+        long *buf = malloc(sizeof(long) * q->cap * 2);
+        if (!buf)
+            return 0;
+        size_t first = q->cap - q->head;
+        memcpy(buf, q->buf + q->head, sizeof(long) * first);
+        memcpy(buf + first, q->buf, sizeof(long) * q->head);
+        free(q->buf);
+        q->buf = buf;
+        q->head = 0;
+        q->cap *= 2;
+    }
+    q->buf[(q->head + q->len) & (q->cap - 1)] = idx;
+    q->len++;
+    return 1;
+}
+
+long queue_pop(queue_t *q) {
+    long idx = q->buf[q->head];
+    q->head = (q->head + 1) & (q->cap - 1);
+    q->len--;
+    return idx;
+}
+
+int bq_init(bucket_queue_t *q, long span) {
+    q->nb = 1;
+    while (q->nb <= span)
+        q->nb *= 2;
+    q->min = 0;
+    q->size = 0;
+    q->buf = calloc(q->nb, sizeof(long *));
+    q->len = calloc(q->nb, sizeof(size_t));
+    q->cap = calloc(q->nb, sizeof(size_t));
+    return q->buf && q->len && q->cap;
+}
+
+void bq_free(bucket_queue_t *q) {
+    if (q->buf)
+        for (long i = 0; i < q->nb; i++)
+            free(q->buf[i]);
+    free(q->buf);
+    free(q->len);
+    free(q->cap);
+}
+
+int bq_push(bucket_queue_t *q, long key, long idx) {
+    long b = key & (q->nb - 1);
+    if (q->len[b] == q->cap[b]) {
+        size_t cap = q->cap[b] ? q->cap[b] * 2 : 256;
+        long *buf = realloc(q->buf[b], sizeof(long) * cap);
+        if (!buf)
+            return 0;
+        q->buf[b] = buf;
+        q->cap[b] = cap;
+    }
+    q->buf[b][q->len[b]++] = idx;
+    q->size++;
+    return 1;
+}
+
+long bq_pop(bucket_queue_t *q, long *key) {
+    long b;
+    while (!q->len[b = q->min & (q->nb - 1)])
+        q->min++;
+    q->size--;
+    *key = q->min;
+    return q->buf[b][--q->len[b]];
+}
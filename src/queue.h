@@ -0,0 +1,87 @@
+/*
+ * Queues of tile indices used by the search solvers
+ */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <stddef.h>
+
+/*
+ * A ring buffer of tile indices
+ */
+typedef struct queue_t {
+    long *buf;
+    /* capacity, always a power of two */
+    size_t cap;
+    size_t head, len;
+} queue_t;
+
+/*
+ * Initialises an empty queue
+ *
+ * returns 1 on success
+ * returns 0 when out of memory
+ */
+int queue_init(queue_t *q);
+
+/*
+ * Adds idx to the back of the queue
+ *
+ * returns 1 on success
+ * returns 0 when out of memory
+ */
+int queue_push(queue_t *q, long idx);
+
+/*
+ * Removes and returns the index at the front of the queue.
+ * The queue must not be empty.
+ */
+long queue_pop(queue_t *q);
+
+/*
+ * A monotone bucket queue of tile indices.
+ * Keys that are pushed must lie within [min, min + nb), where min is the
+ * key of the last pop. Indices with equal keys are popped LIFO.
+ */
+typedef struct bucket_queue_t {
+    /* one growable stack per bucket */
+    long **buf;
+    size_t *len, *cap;
+    /* number of buckets, a power of two */
+    long nb;
+    /* the smallest key that can be in the queue */
+    long min;
+    /* total number of indices in the queue */
+    size_t size;
+} bucket_queue_t;
+
+/*
+ * Initialises a bucket queue for keys that are at most span larger than
+ * the smallest key in the queue.
+ *
+ * returns 1 on success
+ * returns 0 when out of memory
+ */
+int bq_init(bucket_queue_t *q, long span);
+
+/*
+ * Frees the buckets of the queue
+ */
+void bq_free(bucket_queue_t *q);
+
+/*
+ * Adds idx with key key to the queue
+ *
+ * returns 1 on success
+ * returns 0 when out of memory
+ */
+int bq_push(bucket_queue_t *q, long key, long idx);
+
+/*
+ * Pops an index with the smallest key, the key is stored in key.
+ * The queue must not be empty.
+ */
+long bq_pop(bucket_queue_t *q, long *key);
+
+#endif /* QUEUE_H */
@@ -20,9 +20,11 @@
 #include <stdarg.h>
 #include <sys/ioctl.h>
 #include <string.h>
+#include <errno.h>
 #include "renderer.h"
 #include "mazedef.h"
 #include "walkerdef.h"
+#include "overview.h"
 
 /* the state of the renderer */
 ren_state_t rs;
@@ -30,9 +32,106 @@ ren_state_t rs;
 /* the viewport that is used when rendering */
 viewport_t vp;
 
+/*
+ * The frame on the terminal, the cells of viewport shown_vp row by row.
+ * A new frame only prints the cells that differ from it.
+ */
+static uint8_t *shown, *next;
+static size_t shown_size;
+static viewport_t shown_vp;
+/* 0 = the terminal does not show the frame, redraw all cells */
+static int shown_valid;
+
+/*
+ * A frame is composed in out and printed with a single write().
+ * A cell takes at most a cursor move, a colour and a glyph.
+ */
+#define CELL_BYTES 32
+static char *out;
+static size_t out_size;
+
+/* the colours of the cells */
+enum { COL_NONE, COL_WALKER, COL_START, COL_EXIT, COL_CROWD };
+static const char *colours[] = {CNRM, CBLU, CGRN, CRED, CYEL};
+
+/* the glyph and the colour of every cell code, see init_glyphs() */
+static const char *glyph[256];
+static uint8_t glyph_len[256], glyph_col[256];
+
+/* the glyph of a wall, indexed by the directions without a wall next to it */
+static const char *wall_glyph(int mask) {
+    int walls[4] = {0};
+
+    for (int i = 0; i < 4; i++)
+        walls[i] = !((mask >> i) & 1);
+
+    if(walls[WEST] && walls[EAST] && walls[NORTH] && walls[SOUTH])
+        return MR_WALL_FULL;
+    else if(walls[WEST] && walls[EAST] && walls[NORTH])
+        return MR_WALL_TOP_LEFT_RIGHT;
+    else if(walls[WEST] && walls[EAST] && walls[SOUTH])
+        return MR_WALL_RIGHT_BOTTOM_LEFT;
+    else if(walls[WEST] && walls[NORTH] && walls[SOUTH])
+        return MR_WALL_TOP_BOTTOM_LEFT;
+    else if(walls[SOUTH] && walls[NORTH] && walls[EAST])
+        return MR_WALL_TOP_RIGHT_BOTTOM;
+    else if(walls[WEST] && walls[NORTH])
+        return MR_WALL_TOP_LEFT;
+    else if(walls[NORTH] && walls[EAST])
+        return MR_WALL_TOP_RIGHT;
+    else if(walls[SOUTH] && walls[WEST])
+        return MR_WALL_BOTTOM_LEFT;
+    else if(walls[SOUTH] && walls[EAST])
+        return MR_WALL_RIGHT_BOTTOM;
+    else if(walls[NORTH] || walls[SOUTH])
+        return MR_WALL_VER;
+    else if(walls[WEST] || walls[EAST])
+        return MR_WALL_HOR;
+    else
+        return MR_WALL_EMPTY;
+}
+
+/* fills the glyph map once, the glyphs of the cells never change */
+static void init_glyphs(void) {
+    static char chars[CELL_WALL][2];
+    static const char *digits[] = {"0", "1", "2", "3", "4", "5", "6", "7",
+        "8", "9"};
+    static int ready = 0;
+
+    if (ready)
+        return;
+    ready = 1;
+    for (int c = 0; c < CELL_WALL; c++) {
+        chars[c][0] = c;
+        glyph[c] = chars[c];
+    }
+    /* a NUL would end the glyph string, print it as a space */
+    glyph[0] = " ";
+    for (int mask = 0; mask < 16; mask++)
+        glyph[CELL_WALL + mask] = wall_glyph(mask);
+    glyph[CELL_WALKER] = MR_WALKER;
+    glyph_col[CELL_WALKER] = COL_WALKER;
+    glyph[CELL_START] = MR_START;
+    glyph_col[CELL_START] = COL_START;
+    glyph[CELL_EXIT] = MR_EXIT;
+    glyph_col[CELL_EXIT] = COL_EXIT;
+    glyph[CELL_CROWD] = MR_CROWD;
+    glyph_col[CELL_CROWD] = COL_CROWD;
+    for (int n = 1; n <= 9; n++) {
+        glyph[CELL_COUNT + n] = digits[n];
+        glyph_col[CELL_COUNT + n] = COL_CROWD;
+    }
+    for (int c = 0; c < 256; c++) {
+        if (!glyph[c])
+            glyph[c] = "?";
+        glyph_len[c] = strlen(glyph[c]);
+    }
+}
+
 void clear_term() {
     printf(SQ_CLEAR);
     fflush(stdout);
+    shown_valid = 0;
 }
 
 void clear_printed() {
@@ -40,29 +139,191 @@ void clear_printed() {
     fflush(stdout);
 }
 
-int render_maze(maze_t *m, walker_t *w) {
+/* appends the decimal digits of n to o, returns the end */
+static char* put_num(char *o, int n) {
+    char d[12];
+    int i = 0;
+    do {
+        d[i++] = '0' + n % 10;
+        n /= 10;
+    } while (n);
+    while (i)
+        *o++ = d[--i];
+    return o;
+}
+
+/* appends the cursor move to row r, column c, both from 0 */
+static char* put_goto(char *o, int r, int c) {
+    *o++ = '\033';
+    *o++ = '[';
+    o = put_num(o, r + 1);
+    *o++ = ';';
+    o = put_num(o, c + 1);
+    *o++ = 'H';
+    return o;
+}
+
+/* appends the glyph of cell, and its colour when it differs from *col */
+static inline char* put_glyph(char *o, uint8_t cell, int *col) {
+    if (rs.coloured && glyph_col[cell] != *col) {
+        *col = glyph_col[cell];
+        o = stpcpy(o, colours[*col]);
+    }
+    memcpy(o, glyph[cell], glyph_len[cell]);
+    return o + glyph_len[cell];
+}
+
+int write_frame(const char *buf, size_t len) {
+    /* text printed through stdio goes first */
+    fflush(stdout);
+    while (len) {
+        ssize_t n = write(STDOUT_FILENO, buf, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return 0;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 1;
+}
+
+/*
+ * returns 1 when old has the size of vp and the focus is at least a
+ * quarter of the viewport away from every edge of old that is not an
+ * edge of the maze
+ */
+static int keeps_focus(maze_t *m, viewport_t *old, viewport_t *vp) {
+    int w = vp->br.x - vp->tl.x, h = vp->br.y - vp->tl.y;
+    if (old->br.x - old->tl.x != w || old->br.y - old->tl.y != h)
+        return 0;
+    point_t *f = rs.focus;
+    if (f->x < (old->tl.x ? old->tl.x + w / 4 : 0)
+            || f->x >= (old->br.x < m->c ? old->br.x - w / 4 : m->c)
+            || f->y < (old->tl.y ? old->tl.y + h / 4 : 0)
+            || f->y >= (old->br.y < m->r ? old->br.y - h / 4 : m->r))
+        return 0;
+    return 1;
+}
+
+/* sets the cell of p in the frame in next when p is in the viewport */
+static void compose_point(maze_t *m, walker_t *w, int vw, point_t p) {
+    if (p.x >= vp.tl.x && p.x < vp.br.x && p.y >= vp.tl.y && p.y < vp.br.y)
+        next[(long) (p.y - vp.tl.y) * vw + p.x - vp.tl.x] = tile_cell(m, w, p);
+}
 
-    /* clear lines */
-    clear_printed();
+/*
+ * composes the cells of the viewport in next, the open tiles and the walls
+ * row by row, then the few tiles that show something else
+ */
+static void compose(maze_t *m, walker_t *w, int vw) {
+    uint8_t *cell = next;
+    for (int r = vp.tl.y; r < vp.br.y; r++) {
+        long idx = maze_idx(m, (point_t) {vp.tl.x, r});
+        for (int c = 0; c < vw; c++, idx++) {
+            uint32_t n;
+            if (rs.occupancy && (n = rs.occupancy[idx]))
+                *cell++ = n > 9 ? CELL_CROWD : CELL_COUNT + n;
+            else if (maze_open(m, idx))
+                *cell++ = OPEN;
+            else if (m->open)
+                *cell++ = CELL_WALL + m->open[idx];
+            else
+                *cell++ = CELL_WALL + tile_mask(m, (point_t) {vp.tl.x + c, r});
+        }
+    }
+    compose_point(m, w, vw, m->start);
+    compose_point(m, w, vw, m->exit);
+    if (w)
+        compose_point(m, w, vw, w->pos);
+}
 
-    if (!m || !w)
+int render_maze(maze_t *m, walker_t *w) {
+    if (!m || (!w && !rs.occupancy))
         return MRERR_INVARG;
+    if (rs.overview) {
+        /* the tiles have to be redrawn when the overview is turned off */
+        shown_valid = 0;
+        return render_overview(rs.overview, w, &rs);
+    }
 
     int err;
     /* calculate viewport */
     if ((err = calc_viewport(m, &vp)) != MRSUCC)
         return err;
-
-    /* render tiles using viewport */
-    for (int r = vp.tl.y; r < vp.br.y; r++) {
-        for (int c = vp.tl.x; c < vp.br.x; c++) {
-            point_t p = {c, r};
-            render_tile(m, w, p);
+    /* keep the viewport of the last frame while the focus is not near its
+     * edge, a scroll redraws every cell */
+    if (shown_valid && keeps_focus(m, &shown_vp, &vp))
+        vp = shown_vp;
+
+    int vw = vp.br.x - vp.tl.x, vh = vp.br.y - vp.tl.y;
+    size_t size = (size_t) vw * vh;
+    if (size > shown_size) {
+        uint8_t *a = realloc(shown, size), *b;
+        if (a)
+            shown = a;
+        if (!a || !(b = realloc(next, size)))
+            return MRERR_NOMEM;
+        next = b;
+        shown_size = size;
+        shown_valid = 0;
+    }
+    size_t need = size * CELL_BYTES + (size_t) vh + 64;
+    if (need > out_size) {
+        char *o = realloc(out, need);
+        if (!o)
+            return MRERR_NOMEM;
+        out = o;
+        out_size = need;
+    }
+    init_glyphs();
+
+    compose(m, w, vw);
+
+    char *o = out;
+    int col = COL_NONE;
+    if (!shown_valid || vp.tl.x != shown_vp.tl.x || vp.tl.y != shown_vp.tl.y
+            || vp.br.x != shown_vp.br.x || vp.br.y != shown_vp.br.y) {
+        /* the viewport scrolled, every cell moved */
+        o = stpcpy(o, SQ_GOTO_1_1);
+        for (int r = 0; r < vh; r++) {
+            const uint8_t *row = next + (size_t) r * vw;
+            for (int c = 0; c < vw; c++)
+                o = put_glyph(o, row[c], &col);
+            *o++ = '\n';
         }
-        putchar('\n');
+    } else {
+        /* the cursor is left behind the last printed cell, cells next to
+         * each other on a row need no cursor move. The first cell of a row
+         * always does, the viewport may be narrower than the terminal */
+        long at = -1;
+        for (int r = 0; r < vh; r++) {
+            for (int c = 0; c < vw; c++) {
+                long i = (long) r * vw + c;
+                if (next[i] == shown[i])
+                    continue;
+                if (i != at || c == 0)
+                    o = put_goto(o, r, c);
+                o = put_glyph(o, next[i], &col);
+                at = i + 1;
+            }
+        }
+        /* leave the cursor below the frame like a full redraw does */
+        o = put_goto(o, vh, 0);
+    }
+    if (col != COL_NONE)
+        o = stpcpy(o, CNRM);
+    if (!write_frame(out, o - out)) {
+        shown_valid = 0;
+        return MRERR_WRITE;
     }
 
-    fflush(stdout);
+    uint8_t *t = shown;
+    shown = next;
+    next = t;
+    shown_vp = vp;
+    shown_valid = 1;
     return MRSUCC;
 }
 
@@ -112,67 +373,24 @@ int calc_viewport(maze_t *m, viewport_t *vp) {
     return MRSUCC;
 }
 
-void render_tile(maze_t *m, walker_t *w, point_t p) {
-    if(point_equals(&p, &(w->pos))) {
-        if (rs.coloured)
-            printf(CBLU "%s" CNRM, MR_WALKER);
-        else
-            printf(MR_WALKER);
-
-        return;
-    }
-
-    switch (m->maze[p.y][p.x]) {
-        case WALL:
-            render_wall(m, p);
-            break;
-        case START:
-            if (rs.coloured)
-                printf(CGRN "%s" CNRM, MR_START);
-            else
-                printf(MR_START);
-            break;
-        case EXIT:
-            if (rs.coloured)
-                printf(CRED "%s" CNRM, MR_EXIT);
-            else
-                printf(MR_EXIT);
-            break;
-        default:
-            putchar(m->maze[p.y][p.x]);
-    }
-}
-
-void render_wall(maze_t *m, point_t p) {
-    int walls[4] = {0};
-
-    for (int i = 0; i < 4; i++)
-        walls[i] = (tile_dir(m, p, i) == WALL);
-
-    if(walls[WEST] && walls[EAST] && walls[NORTH] && walls[SOUTH])
-        printf("%s", MR_WALL_FULL);
-    else if(walls[WEST] && walls[EAST] && walls[NORTH])
-        printf("%s", MR_WALL_TOP_LEFT_RIGHT);
-    else if(walls[WEST] && walls[EAST] && walls[SOUTH])
-        printf("%s", MR_WALL_RIGHT_BOTTOM_LEFT);
-    else if(walls[WEST] && walls[NORTH] && walls[SOUTH])
-        printf("%s", MR_WALL_TOP_BOTTOM_LEFT);
-    else if(walls[SOUTH] && walls[NORTH] && walls[EAST])
-        printf("%s", MR_WALL_TOP_RIGHT_BOTTOM);
-    else if(walls[WEST] && walls[NORTH])
-        printf("%s", MR_WALL_TOP_LEFT);
-    else if(walls[NORTH] && walls[EAST])
-        printf("%s", MR_WALL_TOP_RIGHT);
-    else if(walls[SOUTH] && walls[WEST])
-        printf("%s", MR_WALL_BOTTOM_LEFT);
-    else if(walls[SOUTH] && walls[EAST])
-        printf("%s", MR_WALL_RIGHT_BOTTOM);
-    else if(walls[NORTH] || walls[SOUTH])
-        printf("%s", MR_WALL_VER);
-    else if(walls[WEST] || walls[EAST])
-        printf("%s", MR_WALL_HOR);
-    else
-        printf("%s", MR_WALL_EMPTY);
+uint8_t tile_cell(maze_t *m, walker_t *w, point_t p) {
+    if (w && point_equals(&p, &(w->pos)))
+        return CELL_WALKER;
+
+    long idx = maze_idx(m, p);
+    uint32_t n;
+    if (rs.occupancy && (n = rs.occupancy[idx]))
+        return n > 9 ? CELL_CROWD : CELL_COUNT + n;
+
+    /* the open direction masks of the maze are the glyph index of its
+     * walls, they are made once per maze by build_open_masks() */
+    if (!maze_open(m, idx))
+        return CELL_WALL + tile_mask(m, p);
+    if (point_equals(&p, &m->start))
+        return CELL_START;
+    if (point_equals(&p, &m->exit))
+        return CELL_EXIT;
+    return OPEN;
 }
 
 
@@ -180,14 +398,22 @@ void render_wall(maze_t *m, point_t p) {
  * functions to change the renderer settings 
  */
 
+void rs_set_occupancy(const uint32_t *occ) {
+    rs.occupancy = occ;
+}
+
+void rs_set_overview(overview_t *o) {
+    rs.overview = o;
+}
+
 void rs_set_coloured(int c) {
     rs.coloured = c;
 }
 
 void rs_detect_dim(void) {
     struct winsize w;
-    ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
-    rs_set_dimensions(w.ws_col, w.ws_row);
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) == 0 && w.ws_col && w.ws_row)
+        rs_set_dimensions(w.ws_col, w.ws_row);
 }
 
 void rs_set_focus(point_t *p) {
@@ -211,6 +437,12 @@ void mrerror(const char *msg, int err) {
         case MRERR_NOFOCUS:
             e = "Viewport focus is not defined";
             break;
+        case MRERR_NOMEM:
+            e = "Out of memory";
+            break;
+        case MRERR_WRITE:
+            e = "Failed to write the frame";
+            break;
         default:
             e = "Unknown error";
     }
@@ -17,10 +17,13 @@
 #ifndef RENDERER_H
 #define RENDERER_H
 
+#include <stdint.h>
 #include "maze.h"
 #include "walker.h"
 #include "point.h"
 
+typedef struct overview_t overview_t;
+
 /* the maze draw characters */
 #define MR_WALL_HOR "─"
 #define MR_WALL_VER "│"
@@ -55,12 +58,30 @@
 #define MR_WALKER "@"
 #define MR_START "S"
 #define MR_EXIT "E"
+#define MR_CROWD "*"
 
 /* maze renderer error codes */
 enum {
     MRSUCC = 0,
     MRERR_INVARG = -1,
     MRERR_NOFOCUS = -2,
+    MRERR_NOMEM = -3,
+    MRERR_WRITE = -4,
+};
+
+/*
+ * The cells of a frame.
+ * Codes below CELL_WALL are plain characters, a wall adds the directions
+ * without a wall next to it to CELL_WALL and a tile with 1 to 9 walkers
+ * adds their number to CELL_COUNT.
+ */
+enum {
+    CELL_WALL = 128,
+    CELL_WALKER = CELL_WALL + 16,
+    CELL_START,
+    CELL_EXIT,
+    CELL_CROWD,
+    CELL_COUNT,
 };
 
 /* 
@@ -74,6 +95,13 @@ typedef struct ren_state_t {
     int w, h;
     /* the focus point of the view port */
     point_t *focus;
+    /*
+     * the number of walkers on every tile, indexed like the cells of the
+     * maze, NULL when only the walker is shown
+     */
+    const uint32_t *occupancy;
+    /* the zoomed out view that is shown instead, see overview.h */
+    overview_t *overview;
 
 } ren_state_t;
 
@@ -103,20 +131,20 @@ typedef struct viewport_t {
 
 /*
  * Render maze and walker
+ * The walker may be NULL when an occupancy overlay is shown instead,
+ * see rs_set_occupancy()
+ *
+ * Only the cells that changed since the last frame are printed, the
+ * whole viewport is redrawn when it scrolls or after clear_term(). The
+ * viewport only scrolls when the focus comes near its edge.
+ * A frame is printed with a single write() to stdout.
  */
 int render_maze(maze_t *maze, walker_t *walker);
 
 /*
- * Renders a wall on point p
- * Note: this function assumes that p is in fact a wall
+ * Returns the cell that shows the tile on point p, see the CELL_* codes
  */
-void render_wall(maze_t *m, point_t p);
-
-/*
- * Renders the tile on point p
- */
-void render_tile(maze_t *m, walker_t *w, point_t p);
-
+uint8_t tile_cell(maze_t *m, walker_t *w, point_t p);
 
 /*
  * Calculates a viewport and stores it in vp
@@ -149,6 +177,20 @@ void rs_set_focus(point_t *p);
  */
 void rs_set_dimensions(int w, int h);
 
+/*
+ * Set the occupancy overlay, the number of walkers on every tile indexed
+ * like the cells of the maze. Tiles with walkers show their number, or
+ * MR_CROWD when there are more than 9.
+ * NULL turns the overlay off.
+ */
+void rs_set_occupancy(const uint32_t *occ);
+
+/*
+ * Set the overview that is rendered instead of the tiles around the focus,
+ * NULL shows the tiles again
+ */
+void rs_set_overview(overview_t *o);
+
 /*
  * If c = 1, use coloured output,
  * else use plain text
@@ -157,9 +199,19 @@ void rs_set_coloured(int c);
 
 /*
  * Detect dimensions of terminal and set the viewport accordingly.
+ * Keeps the dimensions when the output is not a terminal.
  */
 void rs_detect_dim(void);
 
+/*
+ * Writes all len bytes of buf to stdout, after the text that is buffered
+ * by stdio
+ *
+ * returns 1 on success
+ * returns 0 on failure
+ */
+int write_frame(const char *buf, size_t len);
+
 /*
  * Print an error message given an error code err.
  */
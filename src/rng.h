@@ -0,0 +1,72 @@
+/*
+ * Random number generators of the solvers
+ *
+ * Every walker has its own xoshiro128** stream, so walkers on different
+ * threads do not share state and a run can be repeated exactly from its
+ * seed.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/*
+ * The state of a xoshiro128** generator, must not be all zero
+ */
+typedef struct rng_t {
+    uint32_t s[4];
+} rng_t;
+
+/*
+ * Returns the next value of a splitmix64 sequence, used to turn a single
+ * seed into the state of a generator
+ */
+static inline uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ * Seeds r, different seeds give independent streams
+ */
+static inline void rng_seed(rng_t *r, uint64_t seed) {
+    do {
+        uint64_t a = splitmix64(&seed), b = splitmix64(&seed);
+        r->s[0] = a;
+        r->s[1] = a >> 32;
+        r->s[2] = b;
+        r->s[3] = b >> 32;
+    } while (!(r->s[0] | r->s[1] | r->s[2] | r->s[3]));
+}
+
+static inline uint32_t rng_rotl(uint32_t x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+/*
+ * Returns the next 32 random bits of r
+ */
+static inline uint32_t rng_next(rng_t *r) {
+    uint32_t *s = r->s;
+    uint32_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint32_t t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 11);
+    return result;
+}
+
+/*
+ * Returns a random number in [0, n)
+ */
+static inline uint32_t rng_below(rng_t *r, uint32_t n) {
+    return ((uint64_t) rng_next(r) * n) >> 32;
+}
+
+#endif /* RNG_H */
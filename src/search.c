@@ -0,0 +1,740 @@
+/*
+ * Search based solvers
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "mazedef.h"
+#include "walkerdef.h"
+#include "search.h"
+#include "timing.h"
+#include "solvers.h"
+#include "queue.h"
+
+long search_size(maze_t *m) {
+    return (long) m->r * m->stride;
+}
+
+path_t* trace_path(maze_t *m, const uint8_t *parents, long from, long to) {
+    path_t *p = malloc(sizeof(path_t));
+    if (!p)
+        return NULL;
+
+    /* count the moves first, so the moves can be stored in order */
+    long len = 0;
+    for (long i = to; i != from; i -= m->off[get_dir2(parents, i)])
+        len++;
+
+    p->moves = calloc((len + 3) / 4 + 1, 1);
+    if (!p->moves) {
+        free(p);
+        return NULL;
+    }
+    p->len = len;
+    p->next = 0;
+    p->expanded = 0;
+    p->time = 0;
+
+    for (long i = to; i != from; ) {
+        direction_t dir = get_dir2(parents, i);
+        set_dir2(p->moves, --len, dir);
+        i -= m->off[dir];
+    }
+    return p;
+}
+
+direction_t path_walker(maze_t *m, walker_t *w) {
+    (void) m;
+    path_t *p = w->state;
+    if (!p || p->next >= p->len)
+        return -1;
+    return get_dir2(p->moves, p->next++);
+}
+
+int path_run(maze_t *m, walker_t *w, long max_steps, long *steps) {
+    path_t *p = w->state;
+    long idx = w->idx, exit = maze_idx(m, m->exit);
+    int status = RUN_BUDGET;
+    long n = 0;
+
+    while (n < max_steps && p->next < p->len) {
+        idx += m->off[get_dir2(p->moves, p->next++)];
+        n++;
+        if (idx == exit) {
+            status = RUN_EXIT;
+            break;
+        }
+    }
+    /* the steps after the end of the path do not move */
+    if (status == RUN_BUDGET)
+        n = max_steps;
+
+    place_walker(m, w, idx);
+    *steps = n;
+    return status;
+}
+
+void free_path(void *state) {
+    path_t *p = state;
+    if (p) {
+        free(p->moves);
+        free(p);
+    }
+}
+
+void report_path(void *state) {
+    path_t *p = state;
+    if (!p)
+        return;
+    printf("Path length %ld, %ld tiles expanded, search took %.3f ms\n",
+            p->len, p->expanded, p->time * 1e3);
+}
+
+int init_bfs(maze_t *m, walker_t *w) {
+    if (w->state != NULL)
+        return 0;
+
+    double t = now_sec();
+    int status = INIT_FAILED;
+    long size = search_size(m);
+    uint64_t *visited = calloc((size + 63) / 64, sizeof(uint64_t));
+    uint8_t *parents = calloc((size + 3) / 4, 1);
+    queue_t q;
+    q.buf = NULL;
+    if (!visited || !parents || !queue_init(&q))
+        goto fail;
+
+    long from = maze_idx(m, m->start);
+    long to = maze_idx(m, m->exit);
+    long expanded = 0;
+    int found = from == to;
+
+    bit_set(visited, from);
+    queue_push(&q, from);
+    while (q.len && !found) {
+        long idx = queue_pop(&q);
+        int mask = maze_open_mask(m, idx);
+        expanded++;
+
+        for (int dir = 0; dir < 4; dir++) {
+            if (!((mask >> dir) & 1))
+                continue;
+            long n = idx + m->off[dir];
+            if (bit_test(visited, n))
+                continue;
+            bit_set(visited, n);
+            set_dir2(parents, n, dir);
+            if (n == to) {
+                found = 1;
+                break;
+            }
+            if (!queue_push(&q, n))
+                goto fail;
+        }
+    }
+
+    if (!found) {
+        fprintf(stderr, "bfs: the exit can not be reached from the start\n");
+        status = INIT_UNREACHABLE;
+        goto fail;
+    }
+
+    path_t *p = trace_path(m, parents, from, to);
+    if (!p)
+        goto fail;
+    p->expanded = expanded;
+    p->time = now_sec() - t;
+    w->state = p;
+
+    free(q.buf);
+    free(parents);
+    free(visited);
+    return 1;
+
+fail:
+    free(q.buf);
+    free(parents);
+    free(visited);
+    return status;
+}
+
+/*
+ * Returns the manhattan distance between the tile with index idx and p
+ */
+static long manhattan(maze_t *m, long idx, point_t p) {
+    long dx = idx % m->stride - p.x;
+    long dy = idx / m->stride - p.y;
+    return (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+}
+
+int init_astar(maze_t *m, walker_t *w) {
+    if (w->state != NULL)
+        return 0;
+
+    double t = now_sec();
+    int status = INIT_FAILED;
+    long size = search_size(m);
+    uint32_t *g = malloc(sizeof(uint32_t) * size);
+    uint64_t *closed = calloc((size + 63) / 64, sizeof(uint64_t));
+    uint8_t *parents = calloc((size + 3) / 4, 1);
+    bucket_queue_t q;
+    q.buf = NULL;
+    q.len = q.cap = NULL;
+    /* a move changes f = g + h by 0 or 2 */
+    if (!g || !closed || !parents || !bq_init(&q, 2))
+        goto fail;
+    memset(g, 0xff, sizeof(uint32_t) * size);
+
+    long from = maze_idx(m, m->start);
+    long to = maze_idx(m, m->exit);
+    long expanded = 0;
+    int found = 0;
+
+    g[from] = 0;
+    q.min = manhattan(m, from, m->exit);
+    bq_push(&q, q.min, from);
+    while (q.size) {
+        long f;
+        long idx = bq_pop(&q, &f);
+        /* skip stale entries of tiles that were reached cheaper later */
+        if (bit_test(closed, idx))
+            continue;
+        bit_set(closed, idx);
+        if (idx == to) {
+            found = 1;
+            break;
+        }
+        expanded++;
+
+        int mask = maze_open_mask(m, idx);
+        uint32_t ng = g[idx] + 1;
+        for (int dir = 0; dir < 4; dir++) {
+            if (!((mask >> dir) & 1))
+                continue;
+            long n = idx + m->off[dir];
+            if (ng >= g[n])
+                continue;
+            g[n] = ng;
+            /* the parent of n can change, clear it before setting it */
+            parents[n >> 2] &= ~(3 << ((n & 3) * 2));
+            set_dir2(parents, n, dir);
+            if (!bq_push(&q, ng + manhattan(m, n, m->exit), n))
+                goto fail;
+        }
+    }
+
+    if (!found) {
+        fprintf(stderr, "astar: the exit can not be reached from the start\n");
+        status = INIT_UNREACHABLE;
+        goto fail;
+    }
+
+    path_t *p = trace_path(m, parents, from, to);
+    if (!p)
+        goto fail;
+    p->expanded = expanded;
+    p->time = now_sec() - t;
+    w->state = p;
+
+    bq_free(&q);
+    free(parents);
+    free(closed);
+    free(g);
+    return 1;
+
+fail:
+    bq_free(&q);
+    free(parents);
+    free(closed);
+    free(g);
+    return status;
+}
+
+/* returned by the jump functions when no jump point is found */
+#define NO_JUMP -1L
+
+/*
+ * The context of a jump point search
+ */
+typedef struct jps_t {
+    maze_t *m;
+    /* the packed grid, see maze_bits() */
+    const uint64_t *bits;
+    /* number of words in a row of bits */
+    long words;
+    /* index of the goal */
+    long goal;
+} jps_t;
+
+static inline int jps_open(const jps_t *j, long idx) {
+    return bit_test(j->bits, idx + j->m->bbase);
+}
+
+/*
+ * Jumps east (dx = 1) or west (dx = -1) from the tile with index idx.
+ * The row is scanned a word at a time for the first tile that is a wall,
+ * the goal, or has a forced neighbour: an open tile above or below it
+ * while the tile above or below the previous tile is a wall.
+ *
+ * returns the index of the jump point or NO_JUMP
+ */
+static long jump_hor(const jps_t *j, long idx, int dx) {
+    long stride = j->m->stride;
+    long y = idx / stride;
+    const uint64_t *row = j->bits + (y + 1) * j->words;
+    const uint64_t *up = row - j->words;
+    const uint64_t *down = row + j->words;
+
+    /* bit positions in the row, column x is bit x + 1 */
+    long b = idx - y * stride + 1 + dx;
+    long goal = j->goal / stride == y ? j->goal - y * stride + 1 : -1;
+
+    for (long k = b >> 6; ; k += dx) {
+        uint64_t stop, uw, dw;
+        if (dx > 0) {
+            /* bit i of uw and dw holds bit i - 1 of up and down */
+            uw = up[k] << 1 | (k ? up[k - 1] >> 63 : 0);
+            dw = down[k] << 1 | (k ? down[k - 1] >> 63 : 0);
+        } else {
+            /* bit i of uw and dw holds bit i + 1 of up and down */
+            int last = k + 1 == j->words;
+            uw = up[k] >> 1 | (last ? 0 : up[k + 1] << 63);
+            dw = down[k] >> 1 | (last ? 0 : down[k + 1] << 63);
+        }
+        stop = ~row[k] | (up[k] & ~uw) | (down[k] & ~dw);
+        if (goal >> 6 == k)
+            stop |= 1ULL << (goal & 63);
+
+        /* ignore the tiles behind the start of the jump */
+        if (k == b >> 6)
+            stop &= dx > 0 ? ~0ULL << (b & 63) : ~0ULL >> (63 - (b & 63));
+        if (!stop)
+            continue;
+
+        long x = (k << 6) + (dx > 0 ? __builtin_ctzll(stop)
+                : 63 - __builtin_clzll(stop));
+        if (!((row[k] >> (x & 63)) & 1))
+            return NO_JUMP;
+        return y * stride + x - 1;
+    }
+}
+
+/*
+ * Jumps north (dy = -1) or south (dy = 1) from the tile with index idx.
+ * Stops at a wall, the goal, a tile with a forced neighbour, or a tile
+ * from which a horizontal jump finds a jump point.
+ *
+ * returns the index of the jump point or NO_JUMP
+ */
+static long jump_ver(const jps_t *j, long idx, int dy) {
+    long step = dy * j->m->stride;
+    for (long n = idx + step; ; n += step) {
+        if (!jps_open(j, n))
+            return NO_JUMP;
+        if (n == j->goal)
+            return n;
+        if ((jps_open(j, n - 1) && !jps_open(j, n - 1 - step))
+                || (jps_open(j, n + 1) && !jps_open(j, n + 1 - step)))
+            return n;
+        if (jump_hor(j, n, 1) != NO_JUMP || jump_hor(j, n, -1) != NO_JUMP)
+            return n;
+    }
+}
+
+static long jump(const jps_t *j, long idx, direction_t dir) {
+    switch (dir) {
+        case NORTH:
+            return jump_ver(j, idx, -1);
+        case EAST:
+            return jump_hor(j, idx, 1);
+        case SOUTH:
+            return jump_ver(j, idx, 1);
+        default:
+            return jump_hor(j, idx, -1);
+    }
+}
+
+/*
+ * Builds the path from tile index from to tile index to out of the jump
+ * points of a search. Between two jump points the path is a straight
+ * line, which is walked back until a tile with a matching g is found.
+ */
+static path_t* trace_jumps(maze_t *m, const uint8_t *parents,
+        const uint32_t *g, long from, long to) {
+    path_t *p = malloc(sizeof(path_t));
+    if (!p)
+        return NULL;
+
+    long len = g[to];
+    p->moves = calloc((len + 3) / 4 + 1, 1);
+    if (!p->moves) {
+        free(p);
+        return NULL;
+    }
+    p->len = len;
+    p->next = 0;
+    p->expanded = 0;
+    p->time = 0;
+
+    for (long i = to; i != from; ) {
+        direction_t dir = get_dir2(parents, i);
+        long k = 0;
+        long n = i;
+        do {
+            set_dir2(p->moves, --len, dir);
+            n -= m->off[dir];
+            k++;
+        } while (g[n] != g[i] - k);
+        i = n;
+    }
+    return p;
+}
+
+int init_jps(maze_t *m, walker_t *w) {
+    if (w->state != NULL)
+        return 0;
+
+    double t = now_sec();
+    int status = INIT_FAILED;
+    long size = search_size(m);
+    jps_t j = {m, maze_bits(m), m->stride / 64, maze_idx(m, m->exit)};
+    uint32_t *g = malloc(sizeof(uint32_t) * size);
+    uint64_t *closed = calloc((size + 63) / 64, sizeof(uint64_t));
+    uint8_t *parents = calloc((size + 3) / 4, 1);
+    bucket_queue_t q;
+    q.buf = NULL;
+    q.len = q.cap = NULL;
+    /* a jump changes f by at most twice its length */
+    if (!j.bits || !g || !closed || !parents
+            || !bq_init(&q, 2 * ((long) m->r + m->c)))
+        goto fail;
+    memset(g, 0xff, sizeof(uint32_t) * size);
+
+    long from = maze_idx(m, m->start);
+    long expanded = 0;
+    int found = 0;
+
+    g[from] = 0;
+    q.min = manhattan(m, from, m->exit);
+    bq_push(&q, q.min, from);
+    while (q.size) {
+        long f;
+        long idx = bq_pop(&q, &f);
+        if (bit_test(closed, idx))
+            continue;
+        bit_set(closed, idx);
+        if (idx == j.goal) {
+            found = 1;
+            break;
+        }
+        expanded++;
+
+        /* every direction but the one it came from */
+        int mask = maze_open_mask(m, idx);
+        if (idx != from)
+            mask &= ~(1 << rotate_dir(get_dir2(parents, idx), LEFT, 2));
+
+        for (int dir = 0; dir < 4; dir++) {
+            if (!((mask >> dir) & 1))
+                continue;
+            long n = jump(&j, idx, dir);
+            if (n == NO_JUMP)
+                continue;
+            long dist = n - idx;
+            if (dir == NORTH || dir == SOUTH)
+                dist /= m->stride;
+            if (dist < 0)
+                dist = -dist;
+
+            uint32_t ng = g[idx] + dist;
+            if (ng >= g[n])
+                continue;
+            g[n] = ng;
+            parents[n >> 2] &= ~(3 << ((n & 3) * 2));
+            set_dir2(parents, n, dir);
+            if (!bq_push(&q, ng + manhattan(m, n, m->exit), n))
+                goto fail;
+        }
+    }
+
+    if (!found) {
+        fprintf(stderr, "jps: the exit can not be reached from the start\n");
+        status = INIT_UNREACHABLE;
+        goto fail;
+    }
+
+    path_t *p = trace_jumps(m, parents, g, from, j.goal);
+    if (!p)
+        goto fail;
+    p->expanded = expanded;
+    p->time = now_sec() - t;
+    w->state = p;
+
+    bq_free(&q);
+    free(parents);
+    free(closed);
+    free(g);
+    return 1;
+
+fail:
+    bq_free(&q);
+    free(parents);
+    free(closed);
+    free(g);
+    return status;
+}
+
+/*
+ * One of the two searches of a bidirectional search
+ */
+typedef struct side_t {
+    maze_t *m;
+    queue_t q;
+    uint64_t *visited;
+    uint8_t *parents;
+    long expanded;
+    /* set when the sides run on separate threads */
+    int atomic;
+} side_t;
+
+/*
+ * Where the two searches met
+ */
+typedef struct meet_t {
+    /*
+     * 0 while searching, 1 when met, -1 when a side ran out of tiles, -2
+     * when out of memory
+     */
+    int state;
+    /* the tile of the start side, and the direction to the exit side */
+    long idx;
+    direction_t dir;
+} meet_t;
+
+/*
+ * The state of a bidirectional search, path must stay the first member
+ */
+typedef struct bipath_t {
+    path_t path;
+    point_t meet;
+} bipath_t;
+
+static int side_init(side_t *s, maze_t *m, long origin, int atomic) {
+    long size = search_size(m);
+    s->m = m;
+    s->expanded = 0;
+    s->atomic = atomic;
+    s->q.buf = NULL;
+    s->visited = calloc((size + 63) / 64, sizeof(uint64_t));
+    s->parents = calloc((size + 3) / 4, 1);
+    if (!s->visited || !s->parents || !queue_init(&s->q))
+        return 0;
+    bit_set(s->visited, origin);
+    return queue_push(&s->q, origin);
+}
+
+static void side_free(side_t *s) {
+    free(s->q.buf);
+    free(s->visited);
+    free(s->parents);
+}
+
+static inline int side_visited(const side_t *s, long i) {
+    if (s->atomic)
+        return (__atomic_load_n(&s->visited[i >> 6], __ATOMIC_ACQUIRE)
+                >> (i & 63)) & 1;
+    return bit_test(s->visited, i);
+}
+
+/*
+ * Marks a tile visited by its own side, which is the only writer
+ */
+static inline void side_claim(side_t *s, long i) {
+    if (s->atomic)
+        __atomic_store_n(&s->visited[i >> 6],
+                s->visited[i >> 6] | 1ULL << (i & 63), __ATOMIC_RELEASE);
+    else
+        bit_set(s->visited, i);
+}
+
+/*
+ * Expands one level of side s.
+ * When a tile visited by side o is found, the meeting is recorded in meet
+ * and 1 is returned. fwd is 1 if s is the side that started at the start.
+ *
+ * returns 1 when the sides met, 0 otherwise, -1 when out of memory
+ */
+static int expand_level(side_t *s, side_t *o, meet_t *meet, int fwd) {
+    maze_t *m = s->m;
+    size_t level = s->q.len;
+
+    while (level--) {
+        long idx = queue_pop(&s->q);
+        int mask = maze_open_mask(m, idx);
+        s->expanded++;
+
+        for (int dir = 0; dir < 4; dir++) {
+            if (!((mask >> dir) & 1))
+                continue;
+            long n = idx + m->off[dir];
+            if (side_visited(o, n)) {
+                int none = 0;
+                if (!s->atomic || __atomic_compare_exchange_n(&meet->state,
+                            &none, 1, 0, __ATOMIC_ACQ_REL,
+                            __ATOMIC_ACQUIRE)) {
+                    /* in threaded mode the exchange already set it */
+                    if (!s->atomic)
+                        meet->state = 1;
+                    meet->idx = fwd ? idx : n;
+                    meet->dir = fwd ? (direction_t) dir
+                        : rotate_dir(dir, LEFT, 2);
+                }
+                return 1;
+            }
+            if (bit_test(s->visited, n))
+                continue;
+            set_dir2(s->parents, n, dir);
+            side_claim(s, n);
+            if (!queue_push(&s->q, n))
+                return -1;
+        }
+    }
+    return 0;
+}
+
+typedef struct side_arg_t {
+    side_t *s, *o;
+    meet_t *meet;
+    int fwd;
+} side_arg_t;
+
+/*
+ * Runs one side of a bidirectional search until the sides meet
+ */
+static void* side_thread(void *arg) {
+    side_arg_t *a = arg;
+    while (!__atomic_load_n(&a->meet->state, __ATOMIC_ACQUIRE)) {
+        /* a side that runs out of tiles proves there is no path */
+        int state = -1;
+        if (a->s->q.len)
+            state = expand_level(a->s, a->o, a->meet, a->fwd) < 0 ? -2 : 0;
+        if (state < 0) {
+            int none = 0;
+            __atomic_compare_exchange_n(&a->meet->state, &none, state, 0,
+                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+        }
+    }
+    return NULL;
+}
+
+int init_bibfs(maze_t *m, walker_t *w) {
+    if (w->state != NULL)
+        return 0;
+
+    double t = now_sec();
+    long from = maze_idx(m, m->start);
+    long to = maze_idx(m, m->exit);
+    int threaded = ss.threads > 1;
+    side_t fs, bs;
+    meet_t meet = {0, from, NORTH};
+    bipath_t *bp = NULL;
+
+    int ok = side_init(&fs, m, from, threaded);
+    ok = side_init(&bs, m, to, threaded) && ok;
+    if (!ok)
+        goto out;
+
+    if (from == to) {
+        /* nothing to search */
+        meet.state = 1;
+    } else if (threaded) {
+        side_arg_t fa = {&fs, &bs, &meet, 1};
+        side_arg_t ba = {&bs, &fs, &meet, 0};
+        pthread_t th;
+        if (pthread_create(&th, NULL, side_thread, &ba)) {
+            ok = 0;
+            goto out;
+        }
+        side_thread(&fa);
+        pthread_join(th, NULL);
+    } else {
+        /* expand the side with the smaller frontier */
+        while (!meet.state) {
+            side_t *s = fs.q.len <= bs.q.len ? &fs : &bs;
+            if (!s->q.len)
+                meet.state = -1;
+            else if (expand_level(s, s == &fs ? &bs : &fs, &meet,
+                        s == &fs) < 0)
+                meet.state = -2;
+        }
+    }
+
+    if (meet.state == -1) {
+        fprintf(stderr, "bibfs: the exit can not be reached from the start\n");
+        ok = INIT_UNREACHABLE;
+        goto out;
+    }
+    if (meet.state < 0) {
+        ok = 0;
+        goto out;
+    }
+
+    /* count the moves of both halves */
+    long flen = 0, blen = 0;
+    long b = meet.idx;
+    for (long i = meet.idx; i != from; i -= m->off[get_dir2(fs.parents, i)])
+        flen++;
+    if (from != to) {
+        b += m->off[meet.dir];
+        for (long i = b; i != to; i -= m->off[get_dir2(bs.parents, i)])
+            blen++;
+    }
+
+    bp = malloc(sizeof(bipath_t));
+    path_t *p = &bp->path;
+    ok = bp && (p->moves = calloc((flen + blen + 1 + 3) / 4 + 1, 1));
+    if (!ok)
+        goto out;
+
+    /* stitch the halves together at the meeting point */
+    p->len = flen + blen + (from != to);
+    p->next = 0;
+    p->expanded = fs.expanded + bs.expanded;
+    bp->meet.x = meet.idx % m->stride;
+    bp->meet.y = meet.idx / m->stride;
+
+    long k = flen;
+    for (long i = meet.idx; i != from; ) {
+        direction_t dir = get_dir2(fs.parents, i);
+        set_dir2(p->moves, --k, dir);
+        i -= m->off[dir];
+    }
+    k = flen;
+    if (from != to)
+        set_dir2(p->moves, k++, meet.dir);
+    for (long i = b; i != to; ) {
+        /* the exit side stores the moves away from the exit */
+        direction_t dir = get_dir2(bs.parents, i);
+        set_dir2(p->moves, k++, rotate_dir(dir, LEFT, 2));
+        i -= m->off[dir];
+    }
+    p->time = now_sec() - t;
+    w->state = bp;
+    bp = NULL;
+
+out:
+    free(bp);
+    side_free(&fs);
+    side_free(&bs);
+    return ok;
+}
+
+void report_bibfs(void *state) {
+    bipath_t *bp = state;
+    if (!bp)
+        return;
+    printf("Searches met at %i, %i\n", bp->meet.x, bp->meet.y);
+    report_path(state);
+}
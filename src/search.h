@@ -0,0 +1,148 @@
+/*
+ * Search based solvers
+ *
+ * These solvers search the maze once when they are initialised and store
+ * the path they found in the walker state. The walker then replays the
+ * path one move per step.
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdint.h>
+#include "point.h"
+#include "maze.h"
+
+/*
+ * A path found by a search solver
+ */
+typedef struct path_t {
+    /* the moves of the path, 2 bits per move */
+    uint8_t *moves;
+    /* number of moves in the path */
+    long len;
+    /* index of the next move to replay */
+    long next;
+
+    /* number of tiles the search expanded */
+    long expanded;
+    /* the time the search took in seconds */
+    double time;
+} path_t;
+
+/*
+ * Returns direction i of an array of directions packed 2 bits each
+ */
+static inline direction_t get_dir2(const uint8_t *a, long i) {
+    return (a[i >> 2] >> ((i & 3) * 2)) & 3;
+}
+
+/*
+ * Stores dir as direction i of an array of directions packed 2 bits each
+ * Note: the direction must be cleared (NORTH) before it is set
+ */
+static inline void set_dir2(uint8_t *a, long i, direction_t dir) {
+    a[i >> 2] |= dir << ((i & 3) * 2);
+}
+
+/*
+ * Returns bit i of bitset s
+ */
+static inline int bit_test(const uint64_t *s, long i) {
+    return (s[i >> 6] >> (i & 63)) & 1;
+}
+
+/*
+ * Sets bit i of bitset s
+ */
+static inline void bit_set(uint64_t *s, long i) {
+    s[i >> 6] |= 1ULL << (i & 63);
+}
+
+/*
+ * Returns the number of tile indices a search over m has to cover.
+ * All tiles of m have an index in [0, search_size(m))
+ */
+long search_size(maze_t *m);
+
+/*
+ * Builds the path from tile index from to tile index to.
+ * parents holds, packed 2 bits per tile, the direction of the move that
+ * was used to reach each tile. The parents are followed back from to
+ * until from is reached. parents may be indexed by tile index plus a
+ * constant, as long as from and to include the same constant.
+ *
+ * returns the path on success
+ * returns NULL when out of memory
+ */
+path_t* trace_path(maze_t *m, const uint8_t *parents, long from, long to);
+
+/*
+ * Solver function shared by all search solvers, replays the path
+ * stored in the walker state.
+ * Returns -1 when the path is finished
+ */
+direction_t path_walker(maze_t *m, walker_t *w);
+
+/*
+ * Run function shared by all search solvers, replays the path without
+ * rendering, see algorithm_t
+ */
+int path_run(maze_t *m, walker_t *w, long max_steps, long *steps);
+
+/*
+ * Frees a path_t stored as walker state
+ */
+void free_path(void *state);
+
+/*
+ * Prints the length of the path and the statistics of the search
+ */
+void report_path(void *state);
+
+/*
+ * Breadth first search from the start to the exit
+ */
+int init_bfs(maze_t *m, walker_t *w);
+
+/*
+ * A* search from the start to the exit with a manhattan distance
+ * heuristic. The open list is a bucket queue on f = g + h.
+ */
+int init_astar(maze_t *m, walker_t *w);
+
+/*
+ * Jump point search (4-connected) from the start to the exit.
+ * A* over jump points, the jumps scan the packed rows a word at a time.
+ * The path between jump points is expanded into single moves.
+ */
+int init_jps(maze_t *m, walker_t *w);
+
+/*
+ * Bidirectional breadth first search, from the start and from the exit
+ * until the two searches meet. With two or more solver threads both
+ * searches run at the same time, in which case the path is not
+ * guaranteed to be the shortest.
+ */
+int init_bibfs(maze_t *m, walker_t *w);
+
+/*
+ * Prints the meeting point of a bidirectional search and
+ * the statistics printed by report_path()
+ */
+void report_bibfs(void *state);
+
+/*
+ * Parallel direction optimizing breadth first search on ss.threads
+ * threads, switches between top-down and bottom-up expansion of the
+ * levels depending on the size of the frontier.
+ */
+int init_pbfs(maze_t *m, walker_t *w);
+
+/*
+ * Prints the statistics of a parallel search, including the number of
+ * threads and the throughput, to compare runs with a different -t
+ */
+void report_pbfs(void *state);
+
+#endif /* SEARCH_H */
@@ -6,26 +6,29 @@
  */
 
 #include <stdlib.h>
-#include <time.h>
 #include <stdio.h>
 #include <string.h>
 #include "walkerdef.h"
+#include "mazedef.h"
 #include "solvers.h"
+#include "search.h"
+#include "flood.h"
+#include "graph.h"
+#include "label.h"
+#include "kernels.h"
 
 /* init function of defined solver algorithms */
-int init_rand_walker(walker_t *w);
-int init_randi_walker(walker_t *w);
-int init_wall_follower(walker_t *w);
+int init_rand_walker(maze_t *m, walker_t *w);
+int init_randi_walker(maze_t *m, walker_t *w);
+int init_wall_follower(maze_t *m, walker_t *w);
 
 /* solve function of defined solver algorithms */
 direction_t rand_walker(maze_t *m, walker_t *w);
 direction_t randi_walker(maze_t *m, walker_t *w);
 direction_t wall_follower(maze_t *m, walker_t *w);
 
-void free_walker_state(void *state) {
-    if(state)
-        free(state);
-}
+/* the settings of the solvers */
+solver_settings_t ss = {1, 0};
 
 /*
  * all algorithms that are available.
@@ -35,14 +38,47 @@ void free_walker_state(void *state) {
  * denote the end of the array when searching throught the array
  */
  algorithm_t algorithms[] = {
-    {"random", rand_walker, init_rand_walker, free_walker_state, "Walkes in a random direction."},
-    {"randomi", randi_walker, init_randi_walker, free_walker_state,
+    {"random", rand_walker, init_rand_walker, NULL, NULL, "Walkes in a random direction.", rand_walker_run},
+    {"randomi", randi_walker, init_randi_walker, NULL, NULL,
         "The same as random except that it favours a different direction "
-        "than the one it came from."},
-    {"wallfollower", wall_follower, init_wall_follower, free_walker_state, "Always keeps a wall on its right hand."},
-    {NULL, NULL, NULL, NULL, NULL}
+        "than the one it came from.", randi_walker_run},
+    {"wallfollower", wall_follower, init_wall_follower, NULL, NULL, "Always keeps a wall on its right hand.", wall_follower_run},
+    {"bfs", path_walker, init_bfs, free_path, report_path,
+        "Breadth first search for the shortest path, then walks it.", path_run},
+    {"astar", path_walker, init_astar, free_path, report_path,
+        "A* search for the shortest path towards the exit, then walks it.", path_run},
+    {"jps", path_walker, init_jps, free_path, report_path,
+        "Jump point search, A* that skips over open areas, then walks "
+        "the path.", path_run},
+    {"bibfs", path_walker, init_bibfs, free_path, report_bibfs,
+        "Breadth first search from both the start and the exit until they "
+        "meet, then walks the path. Uses two threads when allowed.", path_run},
+    {"pbfs", path_walker, init_pbfs, free_path, report_pbfs,
+        "Parallel direction optimizing breadth first search on all "
+        "threads, then walks the path.", path_run},
+    {"flood", path_walker, init_flood, free_path, report_path,
+        "Bit parallel flood fill from the exit, then walks down the "
+        "distances.", path_run},
+    {"graphbfs", graph_walker, init_graph_bfs, free_graph_walk, report_graph,
+        "Breadth first search over the junction graph for the path with "
+        "the fewest corridors, then walks it.", graph_run},
+    {"graphdijkstra", graph_walker, init_graph_dijkstra, free_graph_walk,
+        report_graph, "Dijkstra over the junction graph for the shortest "
+        "path, then walks it.", graph_run},
+    {"graphwall", graph_walker, init_graph_wall, free_graph_walk,
+        report_graph, "The same as wallfollower, but chooses a corridor "
+        "at every junction instead of a move at every tile.", graph_run},
+    {NULL, NULL, NULL, NULL, NULL, NULL, NULL}
 };
 
+void ss_set_threads(int n) {
+    ss.threads = n > 0 ? n : 1;
+}
+
+void ss_set_seed(uint64_t seed) {
+    ss.seed = seed;
+}
+
 void print_algos() {
     algorithm_t *algo = algorithms;
     while (algo->name) {
@@ -63,88 +99,77 @@ algorithm_t *get_algo(const char *name) {
     return NULL;
 }
 
-int init_rand_walker(walker_t *w) {
-    srand(time(NULL));
-    return 1;
+/*
+ * Returns INIT_UNREACHABLE if the maze is labelled and the exit is not
+ * connected to the start, a random walker would walk forever
+ */
+static int exit_connected(maze_t *m) {
+    if (tile_component(m, m->start) == tile_component(m, m->exit))
+        return INIT_OK;
+    fprintf(stderr, "The exit is not connected to the start\n");
+    return INIT_UNREACHABLE;
+}
+
+int init_rand_walker(maze_t *m, walker_t *w) {
+    rng_seed(&w->rng, ss.seed);
+    return exit_connected(m);
 }
 
 direction_t rand_walker(maze_t *m, walker_t *w) {
     /* get all valid directions the walker can go */
-    direction_t dirs[4];
-    int valdirs = 0;
-    for (int dir = 0; dir < 4 ; dir++) {
-        if (check_move(m, w, dir)) {
-            /* fprintf(stderr, "valid move found: %i\n", dir); */
-            dirs[valdirs] = dir;
-            valdirs++;
-        }
-    }
+    int mask = walker_moves(m, w);
+    int valdirs = mask_count[mask];
 
     /* if valid directions are found, return a random direction */
     if (valdirs > 0)
-        return dirs[rand() % valdirs];
+        return mask_select[mask][rng_below(&w->rng, valdirs)];
     else
         return -1;
 }
 
-int init_randi_walker(walker_t *w) {
-    srand(time(NULL));
-    if (w->state != NULL)
-        return 0;
-
-    w->state = malloc(sizeof(direction_t));
-    return 1;
+int init_randi_walker(maze_t *m, walker_t *w) {
+    rng_seed(&w->rng, ss.seed);
+    w->dir = NORTH;
+    return exit_connected(m);
 }
 
 direction_t randi_walker(maze_t *m, walker_t *w) {
 
-    direction_t od = *((direction_t *) w->state);
-    od = rotate_dir(od, LEFT, 2);
-
-    direction_t dirs[4];
-    int valdirs = 0;
-    for (unsigned int dir = 0; dir < 4; dir++) {
-        if (check_move(m, w, dir) && dir != od) {
-            /* fprintf(stderr, "valid move found: %i\n", dir); */
-            dirs[valdirs] = dir;
-            valdirs++;
-        }
-    }
+    direction_t od = rotate_dir(w->dir, LEFT, 2);
+
+    /* all valid directions except the one it came from */
+    int mask = walker_moves(m, w) & ~(1 << od);
+    int valdirs = mask_count[mask];
 
     /* if valid directions are found, return a random direction */
     direction_t nd;
     if (valdirs > 0)
-        nd = dirs[rand() % valdirs];
+        nd = mask_select[mask][rng_below(&w->rng, valdirs)];
     else
         nd = od;
 
-    *((direction_t *)w->state) = nd;
+    w->dir = nd;
     return nd;
 }
 
-int init_wall_follower(walker_t *w) {
-    if (w->state != NULL)
-        return 0;
-    w->state = malloc(sizeof(direction_t));
+int init_wall_follower(maze_t *m, walker_t *w) {
+    (void) m;
+    w->dir = NORTH;
+    cycle_init(&w->cycle);
     return 1;
 }
 
 direction_t wall_follower(maze_t *m, walker_t *w) {
-    if (!w->state)
+    int mask = walker_moves(m, w);
+    if (!mask)
         return -1;
 
-    direction_t cd = *((direction_t *) w->state);
-
-    /* go right by default */
-    cd = rotate_dir(cd, RIGHT, 1);
-
-    /* keep rotating left until correct path is found */
-    while (!check_move(m, w, cd)) {
-        cd = rotate_dir(cd, LEFT, 1);
-    }
+    /* the next move only depends on the position and the last move */
+    if (cycle_step(&w->cycle, w->idx, w->dir))
+        return DIR_HALT;
 
-    *((direction_t *)w->state) = cd;
-    return cd;
+    w->dir = wall_turn[mask][w->dir];
+    return w->dir;
 }
 
 void solver_usage(const char *pre) {
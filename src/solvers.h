@@ -7,37 +7,108 @@
 
 #ifndef SOLVERS_H
 #define SOLVERS_H
+#include <stdint.h>
 #include "maze.h"
 
 
 /*
  * A maze solver algorithms.
  * init will be called before a move is executed.
- * init should return 1 on success, 0 on failure
+ * init should return 1 on success, 0 on failure and INIT_UNREACHABLE
+ * when it found that the exit can not be reached, see init_status_t.
  *
  * funct should generate a direction to move in and return it.
  *
+ * report is optional and prints statistics of the algorithm once
+ * the walk is done.
+ *
  * name is the name used to denote the algorithm
  * description should describe the algorithm in a couple of lines.
+ *
+ * run is optional and walks without rendering, see run_t.
  */
 typedef struct algorithm_t {
 	const char *name;
 	direction_t (*funct)(maze_t *, walker_t *);
 
 	/*
-	 * called on initialisation with a pointer to the walker
+	 * called on initialisation with a pointer to the maze and the walker
 	 * associated with the algorithm.
 	 */
-	int (*init)(walker_t *);
+	int (*init)(maze_t *, walker_t *);
 
 	/*
 	 * called when state in walker must be freed.
 	 * See walkerdef.h
 	 */
 	void (*free)(void *state);
+
+	/*
+	 * called with the state in walker when the walk is done.
+	 */
+	void (*report)(void *state);
 	const char *description;
+
+	/*
+	 * called instead of funct when no steps have to be rendered.
+	 * Takes at most max_steps steps in a single loop, stores the number
+	 * of steps taken in steps and returns a run_status_t.
+	 */
+	int (*run)(maze_t *, walker_t *, long max_steps, long *steps);
 } algorithm_t;
 
+/*
+ * The results of the run function of an algorithm
+ */
+typedef enum {
+	/* all steps were taken without finding the exit */
+	RUN_BUDGET = 0,
+	/* the walker reached the exit */
+	RUN_EXIT,
+	/* the solver halted, see DIR_HALT */
+	RUN_HALT,
+} run_status_t;
+
+/*
+ * The results of the init function of an algorithm
+ */
+typedef enum {
+	/* the solver proved that the exit can not be reached */
+	INIT_UNREACHABLE = -1,
+	/* out of memory or another failure */
+	INIT_FAILED = 0,
+	INIT_OK = 1,
+} init_status_t;
+
+/*
+ * Settings shared by all solvers.
+ * The settings are changed by the ss_* functions
+ */
+typedef struct solver_settings_t {
+	/* the number of threads a solver may use */
+	int threads;
+	/* the seed of the random numbers of the solvers */
+	uint64_t seed;
+} solver_settings_t;
+
+extern solver_settings_t ss;
+
+/*
+ * All available algorithms, the entry after the last one has a NULL name
+ */
+extern algorithm_t algorithms[];
+
+/*
+ * Set the number of threads solvers may use, n should be at least 1
+ */
+void ss_set_threads(int n);
+
+/*
+ * Set the seed of the random numbers of the solvers,
+ * runs with the same seed take the same steps
+ */
+void ss_set_seed(uint64_t seed);
+
 /*
  * Print available algorithms
  */
@@ -0,0 +1,165 @@
+/*
+ * Swarms of random walkers
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "mazedef.h"
+#include "walkerdef.h"
+#include "kernels.h"
+#include "swarm.h"
+#include "rng.h"
+
+void cleanup_swarm(swarm_t *s) {
+    if (!s)
+        return;
+    free(s->idx);
+    free(s->dir);
+    free(s->rng);
+    free(s->id);
+    free(s->hit);
+    free(s);
+}
+
+swarm_t* init_swarm(maze_t *m, long n, int avoid_back, uint64_t seed) {
+    swarm_t *s = calloc(1, sizeof(swarm_t));
+    if (!s)
+        return NULL;
+    s->m = m;
+    s->n = s->nactive = n;
+    s->avoid_back = avoid_back;
+    s->idx = malloc(sizeof(long) * n);
+    s->dir = malloc(n);
+    s->rng = malloc(sizeof(uint32_t) * n);
+    s->id = malloc(sizeof(long) * n);
+    s->hit = malloc(sizeof(long) * n);
+    if (!s->idx || !s->dir || !s->rng || !s->id || !s->hit) {
+        cleanup_swarm(s);
+        return NULL;
+    }
+
+    long start = maze_idx(m, m->start);
+    for (long i = 0; i < n; i++) {
+        s->idx[i] = start;
+        s->dir[i] = NORTH;
+        /* xorshift must not start at 0 */
+        do
+            s->rng[i] = splitmix64(&seed);
+        while (!s->rng[i]);
+        s->id[i] = i;
+        s->hit[i] = -1;
+    }
+    return s;
+}
+
+/*
+ * Moves lanes [first, first + n) one step, mask[i] holds the open
+ * directions of lane first + i
+ */
+static void move_lanes(swarm_t *s, const uint8_t *restrict mask,
+        long first, long n) {
+    long *restrict idx = s->idx + first;
+    uint8_t *restrict dir = s->dir + first;
+    uint32_t *restrict rng = s->rng + first;
+    const long off[4] = {s->m->off[0], s->m->off[1], s->m->off[2],
+        s->m->off[3]};
+    const int avoid = s->avoid_back;
+
+    for (long i = 0; i < n; i++) {
+        uint32_t r = rng[i];
+        r ^= r << 13;
+        r ^= r >> 17;
+        r ^= r << 5;
+        rng[i] = r;
+
+        /*
+         * randomi only walks back when there is no other way,
+         * random chooses from all open directions
+         */
+        int back = dir[i] ^ 2;
+        int all = mask[i];
+        int fwd = all & ~(1 << back);
+        int m = avoid ? (fwd ? fwd : all & (1 << back)) : all;
+        int k = mask_count[m];
+        direction_t d = mask_select[m][((uint64_t) r * k) >> 32];
+
+        dir[i] = k ? (int) d : back;
+        idx[i] += k ? off[d] : 0;
+    }
+}
+
+long swarm_tick(swarm_t *s) {
+    /* the masks are gathered in blocks so they stay in the cache */
+    enum { BLOCK = 1024 };
+    uint8_t mask[BLOCK];
+    maze_t *m = s->m;
+
+    for (long b = 0; b < s->nactive; b += BLOCK) {
+        long n = s->nactive - b < BLOCK ? s->nactive - b : BLOCK;
+        const long *idx = s->idx + b;
+        if (m->open) {
+            const unsigned char *open = m->open;
+            for (long i = 0; i < n; i++)
+                mask[i] = open[idx[i]];
+        } else {
+            for (long i = 0; i < n; i++)
+                mask[i] = maze_open_mask(m, idx[i]);
+        }
+        move_lanes(s, mask, b, n);
+    }
+    s->tick++;
+
+    /* retire the walkers that reached the exit */
+    long exit = maze_idx(m, m->exit);
+    for (long i = 0; i < s->nactive; i++) {
+        if (s->idx[i] != exit)
+            continue;
+        s->hit[s->id[i]] = s->tick;
+        long last = --s->nactive;
+        s->idx[i] = s->idx[last];
+        s->dir[i] = s->dir[last];
+        s->rng[i] = s->rng[last];
+        s->id[i] = s->id[last];
+        /* the lane now holds another walker */
+        i--;
+    }
+    return s->nactive;
+}
+
+void swarm_occupancy(swarm_t *s, uint32_t *occ) {
+    memset(occ, 0, sizeof(uint32_t) * (size_t) s->m->r * s->m->stride);
+    for (long i = 0; i < s->nactive; i++)
+        occ[s->idx[i]]++;
+    /* the walkers that are done wait at the exit */
+    occ[maze_idx(s->m, s->m->exit)] += s->n - s->nactive;
+}
+
+static int cmp_long(const void *a, const void *b) {
+    long x = *(const long *) a, y = *(const long *) b;
+    return (x > y) - (x < y);
+}
+
+void report_swarm(swarm_t *s) {
+    long done = s->n - s->nactive;
+    printf("%ld of %ld walkers found the exit in %ld ticks\n", done, s->n,
+            s->tick);
+    if (!done)
+        return;
+
+    long *t = malloc(sizeof(long) * done);
+    if (!t)
+        return;
+    long k = 0;
+    double sum = 0;
+    for (long i = 0; i < s->n; i++) {
+        if (s->hit[i] < 0)
+            continue;
+        t[k++] = s->hit[i];
+        sum += s->hit[i];
+    }
+    qsort(t, done, sizeof(long), cmp_long);
+    printf("First hit after %ld steps, mean %.1f, median %ld, last %ld\n",
+            t[0], sum / done, t[done / 2], t[done - 1]);
+    free(t);
+}
@@ -0,0 +1,80 @@
+/*
+ * Swarms of random walkers
+ *
+ * Runs many random walkers in lockstep for hitting time studies. The
+ * walkers are stored as a structure of arrays and every tick advances
+ * all walkers that did not reach the exit yet with a loop the compiler
+ * can vectorise: a gather of the open direction masks, a per walker
+ * xorshift random number generator and a table lookup of the move.
+ */
+
+#ifndef SWARM_H
+#define SWARM_H
+
+#include <stdint.h>
+#include "point.h"
+#include "maze.h"
+
+/*
+ * A swarm of random walkers.
+ * Lanes [0, nactive) hold the walkers that are still walking, a walker
+ * that reaches the exit is swapped with the last active lane.
+ */
+typedef struct swarm_t {
+    maze_t *m;
+
+    /* the number of walkers */
+    long n;
+    /* the number of walkers that did not reach the exit yet */
+    long nactive;
+    /* 1 = never walk back the way a walker came from, like randomi */
+    int avoid_back;
+
+    /* per lane: the tile index, the last move and the random state */
+    long *idx;
+    uint8_t *dir;
+    uint32_t *rng;
+    /* the walker in each lane */
+    long *id;
+
+    /* per walker: the tick it reached the exit on, -1 if it did not */
+    long *hit;
+    /* the number of ticks so far */
+    long tick;
+} swarm_t;
+
+/*
+ * Creates a swarm of n walkers on the start of m.
+ * The random state of every walker is derived from seed.
+ *
+ * returns the swarm on success
+ * returns NULL when out of memory
+ */
+swarm_t* init_swarm(maze_t *m, long n, int avoid_back, uint64_t seed);
+
+/*
+ * Moves all walkers that did not reach the exit one step
+ *
+ * returns the number of walkers that did not reach the exit yet
+ */
+long swarm_tick(swarm_t *s);
+
+/*
+ * Counts the number of walkers on every tile into occ, indexed like the
+ * cells of the maze, to be used as the occupancy overlay of the renderer.
+ * occ holds r * stride counts, see mazedef.h
+ */
+void swarm_occupancy(swarm_t *s, uint32_t *occ);
+
+/*
+ * Prints how many walkers reached the exit and the distribution of the
+ * ticks they took
+ */
+void report_swarm(swarm_t *s);
+
+/*
+ * Frees a swarm made by init_swarm()
+ */
+void cleanup_swarm(swarm_t *s);
+
+#endif /* SWARM_H */
@@ -0,0 +1,27 @@
+/*
+ * Wall clock helpers used to time loading and solving
+ */
+
+#include <errno.h>
+#include <time.h>
+#include "timing.h"
+
+double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void sleep_until(double t) {
+    struct timespec ts;
+    ts.tv_sec = (time_t) t;
+    ts.tv_nsec = (long) ((t - ts.tv_sec) * 1e9);
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    /* a signal interrupts the sleep, the deadline stays the same */
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)
+            == EINTR)
+        ;
+}
@@ -0,0 +1,22 @@
+/*
+ * Wall clock helpers used to time loading and solving
+ */
+
+#ifndef TIMING_H
+#define TIMING_H
+
+/*
+ * Returns a monotonic timestamp in seconds.
+ * Only differences between two timestamps are meaningful.
+ */
+double now_sec(void);
+
+/*
+ * Sleeps until the monotonic clock reaches t, a timestamp as returned by
+ * now_sec(). Sleeping until absolute deadlines keeps a loop on its rate,
+ * the time spent between two sleeps does not add up.
+ * Returns immediately when t has already passed.
+ */
+void sleep_until(double t);
+
+#endif /* TIMING_H */
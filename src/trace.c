@@ -0,0 +1,347 @@
+/*
+ * Solver traces
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mazedef.h"
+#include "walkerdef.h"
+#include "trace.h"
+
+/*
+ * The file starts with a header and ends with the keyframe index and a
+ * footer, all numbers are little endian:
+ *
+ * header   "MAZETRC1", rows u32, columns u32, interval u32, 0 u32,
+ *          seed u64, the name of the algorithm in 32 bytes
+ * keyframe step u64, stream offset u64, x u32, y u32, direction u32,
+ *          random state 4 * u32, 0 u32
+ * footer   index offset u64, keyframes u64, steps u64, "MAZETEND"
+ */
+#define HEADER_SIZE 64
+#define KEY_SIZE 48
+#define FOOTER_SIZE 32
+
+struct trace_writer_t {
+    FILE *f;
+    maze_t *m;
+
+    /* the steps recorded and the bytes written to the stream */
+    long step;
+    uint64_t at;
+
+    /* the run of moves in one direction that is not written yet */
+    int run_dir;
+    long run;
+    /* the moves of the group of three that is not written yet */
+    int pack, npack;
+    /* the steps without a move that are not written yet */
+    int stays;
+
+    /* the keyframe index */
+    uint8_t *keys;
+    long nkeys, cap;
+};
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++)
+        p[i] = v >> 8 * i;
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++)
+        p[i] = v >> 8 * i;
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++)
+        v |= (uint32_t) p[i] << 8 * i;
+    return v;
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++)
+        v |= (uint64_t) p[i] << 8 * i;
+    return v;
+}
+
+static void emit(trace_writer_t *t, int byte) {
+    putc(byte, t->f);
+    t->at++;
+}
+
+static void flush_pack(trace_writer_t *t) {
+    if (t->npack)
+        emit(t, TK_PART << 6 | t->npack << 4 | t->pack);
+    t->pack = t->npack = 0;
+}
+
+static void pack_move(trace_writer_t *t, int dir) {
+    t->pack |= dir << 2 * t->npack;
+    if (++t->npack == 3) {
+        emit(t, TK_PACK << 6 | t->pack);
+        t->pack = t->npack = 0;
+    }
+}
+
+static void flush_run(trace_writer_t *t) {
+    if (t->run >= TRACE_RUN_MIN) {
+        flush_pack(t);
+        long n = t->run - TRACE_RUN_MIN;
+        emit(t, TK_RUN << 6 | t->run_dir << 4 | (n < 15 ? n : 15));
+        if (n >= 15) {
+            /* the rest of the run as a varint, 7 bits per byte */
+            for (n -= 15; n >= 0x80; n >>= 7)
+                emit(t, (n & 0x7f) | 0x80);
+            emit(t, n);
+        }
+    } else {
+        for (long i = 0; i < t->run; i++)
+            pack_move(t, t->run_dir);
+    }
+    t->run = 0;
+}
+
+static void flush_stays(trace_writer_t *t) {
+    if (t->stays)
+        emit(t, TK_STAY << 6 | t->stays);
+    t->stays = 0;
+}
+
+/* writes everything that is waiting and adds a keyframe for w */
+static int keyframe(trace_writer_t *t, walker_t *w) {
+    flush_run(t);
+    flush_pack(t);
+    flush_stays(t);
+
+    if (t->nkeys == t->cap) {
+        long cap = t->cap ? 2 * t->cap : 64;
+        uint8_t *k = realloc(t->keys, (size_t) cap * KEY_SIZE);
+        if (!k)
+            return 0;
+        t->keys = k;
+        t->cap = cap;
+    }
+    uint8_t *k = t->keys + (size_t) t->nkeys++ * KEY_SIZE;
+    memset(k, 0, KEY_SIZE);
+    put_u64(k, t->step);
+    put_u64(k + 8, t->at);
+    put_u32(k + 16, w->pos.x);
+    put_u32(k + 20, w->pos.y);
+    put_u32(k + 24, w->dir);
+    for (int i = 0; i < 4; i++)
+        put_u32(k + 28 + 4 * i, w->rng.s[i]);
+    return 1;
+}
+
+trace_writer_t* trace_create(const char *fname, maze_t *m, walker_t *w,
+        const char *algo, uint64_t seed) {
+    trace_writer_t *t = calloc(1, sizeof(trace_writer_t));
+    if (!t)
+        return NULL;
+    t->m = m;
+    if (!(t->f = fopen(fname, "wb"))) {
+        free(t);
+        return NULL;
+    }
+    /* the stream is written a byte at a time */
+    setvbuf(t->f, NULL, _IOFBF, 1 << 16);
+
+    uint8_t h[HEADER_SIZE] = "MAZETRC1";
+    put_u32(h + 8, m->r);
+    put_u32(h + 12, m->c);
+    put_u32(h + 16, TRACE_INTERVAL);
+    put_u64(h + 24, seed);
+    strncpy((char *) h + 32, algo, 31);
+    if (fwrite(h, HEADER_SIZE, 1, t->f) != 1 || !keyframe(t, w)) {
+        fclose(t->f);
+        free(t->keys);
+        free(t);
+        return NULL;
+    }
+    return t;
+}
+
+int trace_step(trace_writer_t *t, walker_t *w, long from) {
+    long delta = w->idx - from;
+    int dir = -1;
+    for (int d = 0; d < 4; d++)
+        if (delta == t->m->off[d])
+            dir = d;
+
+    if (delta == 0) {
+        flush_run(t);
+        flush_pack(t);
+        if (++t->stays == 63)
+            flush_stays(t);
+    } else if (dir < 0) {
+        return 0;
+    } else {
+        flush_stays(t);
+        if (t->run && dir != t->run_dir)
+            flush_run(t);
+        t->run_dir = dir;
+        t->run++;
+    }
+
+    if (++t->step % TRACE_INTERVAL == 0 && !keyframe(t, w))
+        return 0;
+    return !ferror(t->f);
+}
+
+int trace_close(trace_writer_t *t, long *bytes) {
+    flush_run(t);
+    flush_pack(t);
+    flush_stays(t);
+
+    uint8_t f[FOOTER_SIZE] = {0};
+    put_u64(f, HEADER_SIZE + t->at);
+    put_u64(f + 8, t->nkeys);
+    put_u64(f + 16, t->step);
+    memcpy(f + 24, "MAZETEND", 8);
+
+    int ok = fwrite(t->keys, KEY_SIZE, t->nkeys, t->f) == (size_t) t->nkeys
+        && fwrite(f, FOOTER_SIZE, 1, t->f) == 1;
+    if (bytes)
+        *bytes = HEADER_SIZE + t->at + t->nkeys * KEY_SIZE + FOOTER_SIZE;
+    ok &= fclose(t->f) == 0;
+    free(t->keys);
+    free(t);
+    return ok;
+}
+
+trace_t* trace_open(const char *fname, maze_t *m) {
+    int fd = open(fname, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    trace_t *t = calloc(1, sizeof(trace_t));
+    if (!t || fstat(fd, &st) || st.st_size < HEADER_SIZE + FOOTER_SIZE) {
+        free(t);
+        close(fd);
+        return NULL;
+    }
+    t->size = st.st_size;
+    void *d = mmap(NULL, t->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (d == MAP_FAILED) {
+        free(t);
+        return NULL;
+    }
+    t->data = d;
+    t->m = m;
+
+    const uint8_t *h = t->data, *f = t->data + t->size - FOOTER_SIZE;
+    uint64_t index = get_u64(f), nkeys = get_u64(f + 8);
+    if (memcmp(h, "MAZETRC1", 8) || memcmp(f + 24, "MAZETEND", 8)
+            || get_u32(h + 8) != (uint32_t) m->r
+            || get_u32(h + 12) != (uint32_t) m->c
+            || index < HEADER_SIZE || nkeys < 1
+            || index + nkeys * KEY_SIZE + FOOTER_SIZE != t->size) {
+        trace_free(t);
+        return NULL;
+    }
+    t->moves = t->data + HEADER_SIZE;
+    t->nmoves = index - HEADER_SIZE;
+    t->keys = t->data + index;
+    t->nkeys = nkeys;
+    t->steps = get_u64(f + 16);
+    t->seed = get_u64(h + 24);
+    memcpy(t->algo, h + 32, 31);
+    return t;
+}
+
+int trace_seek(trace_t *t, trace_cursor_t *c, long step) {
+    if (step < 0 || step > t->steps)
+        return 0;
+
+    /* the last keyframe at or before step */
+    long lo = 0, hi = t->nkeys - 1;
+    while (lo < hi) {
+        long mid = (lo + hi + 1) / 2;
+        if ((long) get_u64(t->keys + (size_t) mid * KEY_SIZE) <= step)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    const uint8_t *k = t->keys + (size_t) lo * KEY_SIZE;
+    memset(c, 0, sizeof(trace_cursor_t));
+    c->step = get_u64(k);
+    c->at = get_u64(k + 8);
+    c->idx = maze_idx(t->m, (point_t) {get_u32(k + 16), get_u32(k + 20)});
+    if (!maze_open(t->m, c->idx))
+        return -1;
+
+    /* step is in the trace, so trace_next can only fail on a wall */
+    while (c->step < step)
+        if (!trace_next(t, c))
+            return -1;
+    return 1;
+}
+
+int trace_next(trace_t *t, trace_cursor_t *c) {
+    while (!c->left) {
+        if (c->at >= t->nmoves)
+            return 0;
+        int b = t->moves[c->at++];
+        c->kind = b >> 6;
+        switch (c->kind) {
+            case TK_PACK:
+                c->left = 3;
+                c->packed = b & 0x3f;
+                break;
+            case TK_PART:
+                c->left = (b >> 4) & 3;
+                c->packed = b & 0xf;
+                break;
+            case TK_RUN:
+                c->dir = (b >> 4) & 3;
+                c->left = (b & 0xf) + TRACE_RUN_MIN;
+                if ((b & 0xf) == 15) {
+                    long rest = 0;
+                    int shift = 0;
+                    do {
+                        if (c->at >= t->nmoves)
+                            return 0;
+                        b = t->moves[c->at++];
+                        rest |= (long) (b & 0x7f) << shift;
+                        shift += 7;
+                    } while (b & 0x80);
+                    c->left += rest;
+                }
+                break;
+            case TK_STAY:
+                c->left = b & 0x3f;
+                break;
+        }
+    }
+
+    c->left--;
+    if (c->kind == TK_PACK || c->kind == TK_PART) {
+        c->dir = c->packed & 3;
+        c->packed >>= 2;
+    }
+    if (c->kind != TK_STAY) {
+        /* a move into a wall means the stream is corrupt */
+        if (!maze_open(t->m, c->idx + t->m->off[c->dir]))
+            return 0;
+        c->idx += t->m->off[c->dir];
+    }
+    c->step++;
+    return 1;
+}
+
+void trace_free(trace_t *t) {
+    if (!t)
+        return;
+    if (t->data)
+        munmap((void *) t->data, t->size);
+    free(t);
+}
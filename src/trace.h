@@ -0,0 +1,137 @@
+/*
+ * Solver traces
+ *
+ * Records the moves of a walker to a file and plays them back without
+ * running the solver again. The moves are stored as a byte stream:
+ *
+ *     00ccbbaa  three moves a, b and c of 2 bits each
+ *     01ddnnnn  a run of moves in direction d, n + TRACE_RUN_MIN moves,
+ *               n = 15 is followed by a varint with the rest of the run
+ *     10kkbbaa  k (1 or 2) moves a and b, ends a group of three early
+ *     11nnnnnn  n steps without a move
+ *
+ * Every TRACE_INTERVAL steps a keyframe stores the step, the offset in
+ * the stream, the position and the solver state of the walker. The
+ * keyframes are written as an index after the stream, so a reader finds
+ * any step with a binary search and decodes at most one interval.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include "maze.h"
+#include "walker.h"
+
+/* the shortest run of moves in one direction that is stored as a run */
+#define TRACE_RUN_MIN 4
+/* the number of steps between two keyframes */
+#define TRACE_INTERVAL 65536
+
+/* the kinds of the bytes of the stream, the top 2 bits */
+enum { TK_PACK, TK_RUN, TK_PART, TK_STAY };
+
+typedef struct trace_writer_t trace_writer_t;
+
+/*
+ * Creates the trace file fname for the walk of w through m. The name of
+ * the algorithm and the seed are stored for the replay.
+ *
+ * returns the writer on success
+ * returns NULL when the file can not be created or when out of memory
+ */
+trace_writer_t* trace_create(const char *fname, maze_t *m, walker_t *w,
+        const char *algo, uint64_t seed);
+
+/*
+ * Records the step w took from tile index from
+ *
+ * returns 1 on success
+ * returns 0 when the step was not a single move or on a write error
+ */
+int trace_step(trace_writer_t *t, walker_t *w, long from);
+
+/*
+ * Writes the keyframe index, closes the file and frees the writer.
+ * The size of the file is stored in bytes when it is not NULL.
+ *
+ * returns 1 on success
+ * returns 0 on a write error
+ */
+int trace_close(trace_writer_t *t, long *bytes);
+
+/*
+ * A trace opened for playback
+ */
+typedef struct trace_t {
+    maze_t *m;
+    /* the mapped file */
+    const uint8_t *data;
+    size_t size;
+
+    /* the stream of moves */
+    const uint8_t *moves;
+    size_t nmoves;
+    /* the keyframe index */
+    const uint8_t *keys;
+    long nkeys;
+
+    /* the number of steps, the seed and the algorithm of the walk */
+    long steps;
+    uint64_t seed;
+    char algo[32];
+} trace_t;
+
+/*
+ * A position in a trace
+ */
+typedef struct trace_cursor_t {
+    /* the number of steps taken */
+    long step;
+    /* the tile index of the walker */
+    long idx;
+
+    /* the offset of the next byte in the stream */
+    size_t at;
+    /*
+     * the steps left of the current byte, their kind and direction.
+     * The last step moved in direction dir unless kind is TK_STAY
+     */
+    long left;
+    int kind, dir;
+    /* the packed moves left of the current byte */
+    int packed;
+} trace_cursor_t;
+
+/*
+ * Opens the trace file fname of a walk through m
+ *
+ * returns the trace on success
+ * returns NULL when the file can not be read, is no trace or was recorded
+ * on a maze of another size
+ */
+trace_t* trace_open(const char *fname, maze_t *m);
+
+/*
+ * Moves c to step of t, starting from the last keyframe before it
+ *
+ * returns 1 on success
+ * returns 0 when step is past the end of the trace
+ * returns -1 when the trace walks into a wall, it does not match the maze
+ */
+int trace_seek(trace_t *t, trace_cursor_t *c, long step);
+
+/*
+ * Takes the next step of the trace, c->idx is the new position
+ *
+ * returns 1 on success
+ * returns 0 at the end of the trace or when the stream is corrupt
+ */
+int trace_next(trace_t *t, trace_cursor_t *c);
+
+/*
+ * Unmaps and frees a trace made by trace_open()
+ */
+void trace_free(trace_t *t);
+
+#endif /* TRACE_H */
@@ -0,0 +1,166 @@
+/*
+ * Monte Carlo trials of the random walkers
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include "mazedef.h"
+#include "walkerdef.h"
+#include "solvers.h"
+#include "trials.h"
+#include "timing.h"
+
+/* the width of the longest bar of the histogram */
+#define BAR_WIDTH 50
+
+/*
+ * The work shared by the threads running the trials
+ */
+typedef struct trials_t {
+    maze_t *m;
+    algorithm_t *a;
+    long n, max_steps;
+    uint64_t seed;
+
+    /* the next trial to run, taken with an atomic add */
+    long next;
+    /* per trial: the steps until the exit was hit, -1 if it was not */
+    long *hit;
+    /*
+     * 1 when a walk could not be started, -1 when its solver found that
+     * the exit can not be reached
+     */
+    int failed;
+} trials_t;
+
+static void* trial_thread(void *arg) {
+    trials_t *t = arg;
+    long i;
+    while ((i = __atomic_fetch_add(&t->next, 1, __ATOMIC_RELAXED)) < t->n) {
+        walker_t *w = init_walker(t->m, t->a->funct);
+        int init = INIT_FAILED;
+        if (w)
+            init = t->a->init ? t->a->init(t->m, w) : INIT_OK;
+        if (init != INIT_OK) {
+            cleanup_walker(w);
+            __atomic_store_n(&t->failed, init == INIT_UNREACHABLE ? -1 : 1,
+                    __ATOMIC_RELAXED);
+            break;
+        }
+        rng_seed(&w->rng, t->seed + i);
+
+        long steps;
+        int status = t->a->run(t->m, w, t->max_steps, &steps);
+        t->hit[i] = status == RUN_EXIT ? steps : -1;
+
+        if (t->a->free)
+            t->a->free(w->state);
+        cleanup_walker(w);
+    }
+    return NULL;
+}
+
+static int cmp_long(const void *a, const void *b) {
+    long x = *(const long *) a, y = *(const long *) b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Returns the index of the highest bit set in x, x must not be 0
+ */
+static int high_bit(long x) {
+    return 63 - __builtin_clzl(x);
+}
+
+/*
+ * Prints the statistics and a histogram of the sorted hitting times
+ */
+static void report_trials(const long *t, long hits, long n) {
+    printf("%ld of %ld walks hit the exit\n", hits, n);
+    if (!hits)
+        return;
+
+    double sum = 0;
+    for (long i = 0; i < hits; i++)
+        sum += t[i];
+    printf("Steps: min %ld, mean %.1f, p50 %ld, p90 %ld, p99 %ld, max %ld\n",
+            t[0], sum / hits, t[hits / 2], t[hits * 9 / 10],
+            t[hits * 99 / 100], t[hits - 1]);
+
+    /* powers of two buckets, the hitting times have a long tail */
+    long count[64] = {0}, most = 0;
+    int lo = high_bit(t[0]), hi = high_bit(t[hits - 1]);
+    for (long i = 0; i < hits; i++)
+        count[high_bit(t[i])]++;
+    for (int b = lo; b <= hi; b++)
+        if (count[b] > most)
+            most = count[b];
+    for (int b = lo; b <= hi; b++) {
+        printf("%12ld - %-12ld %8ld ", 1L << b, (1L << b) * 2 - 1,
+                count[b]);
+        for (long k = count[b] * BAR_WIDTH / most; k > 0; k--)
+            putchar('#');
+        putchar('\n');
+    }
+}
+
+int run_trials(maze_t *m, algorithm_t *a, long n, long max_steps,
+        int threads, uint64_t seed) {
+    trials_t t = {m, a, n, max_steps, seed, 0, NULL, 0};
+    t.hit = malloc(sizeof(long) * n);
+    pthread_t *tids = malloc(sizeof(pthread_t) * threads);
+    if (!t.hit || !tids) {
+        free(t.hit);
+        free(tids);
+        return 0;
+    }
+
+    /*
+     * the solvers build some tables of the maze on first use, build them
+     * before the trials share the maze
+     */
+    if ((m->cells && !build_open_masks(m)) || !maze_bits(m)) {
+        free(t.hit);
+        free(tids);
+        return 0;
+    }
+    /* the trials run in parallel, the solvers of a trial do not */
+    int solver_threads = ss.threads;
+    ss_set_threads(1);
+
+    double time = now_sec();
+    int started = 0;
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&tids[i], NULL, trial_thread, &t))
+            break;
+        started++;
+    }
+    trial_thread(&t);
+    for (int i = 1; i <= started; i++)
+        pthread_join(tids[i], NULL);
+    time = now_sec() - time;
+    free(tids);
+    ss_set_threads(solver_threads);
+
+    if (t.failed) {
+        free(t.hit);
+        return t.failed < 0 ? -1 : 0;
+    }
+
+    /* sort the hits to the front for the percentiles */
+    long hits = 0, steps = 0;
+    for (long i = 0; i < n; i++) {
+        steps += t.hit[i] < 0 ? max_steps : t.hit[i];
+        if (t.hit[i] >= 0)
+            t.hit[hits++] = t.hit[i];
+    }
+    qsort(t.hit, hits, sizeof(long), cmp_long);
+
+    fprintf(stderr, "%ld walks on %d threads in %.3f ms "
+            "(%.1f M steps/s)\n", n, started + 1, time * 1e3,
+            time > 0 ? steps / time / 1e6 : 0.0);
+    report_trials(t.hit, hits, n);
+    free(t.hit);
+    return 1;
+}
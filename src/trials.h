@@ -0,0 +1,30 @@
+/*
+ * Monte Carlo trials of the random walkers
+ *
+ * Runs many independent walks from the start and reports the
+ * distribution of the number of steps they took to hit the exit.
+ * Trial i uses the random stream seeded with seed + i, so the results
+ * only depend on the seed and not on the number of threads.
+ */
+
+#ifndef TRIALS_H
+#define TRIALS_H
+
+#include <stdint.h>
+#include "maze.h"
+#include "solvers.h"
+
+/*
+ * Runs n walks of at most max_steps steps with algorithm a on the given
+ * number of threads, then prints the hitting time distribution.
+ * a must have a run function. The solvers of the trials run on a
+ * single thread each.
+ *
+ * returns 1 on success
+ * returns 0 when out of memory or when a walk could not be started
+ * returns -1 when the solver found that the exit can not be reached
+ */
+int run_trials(maze_t *m, algorithm_t *a, long n, long max_steps,
+        int threads, uint64_t seed);
+
+#endif /* TRIALS_H */
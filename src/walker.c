@@ -11,11 +11,15 @@
 #include "mazedef.h"
 #include "renderer.h"
 int check_move(maze_t *m, walker_t *w, direction_t dir) {
-    if (!m || !w)
+    if (!m || !w || (unsigned) dir > WEST)
         return 0;
-    if (tile_dir(m, w->pos, dir) == WALL)
+    return (maze_open_mask(m, w->idx) >> dir) & 1;
+}
+
+int walker_moves(maze_t *m, walker_t *w) {
+    if (!m || !w)
         return 0;
-    return 1;
+    return maze_open_mask(m, w->idx);
 }
 
 int at_exit(maze_t *m, walker_t *w) {
@@ -25,13 +29,17 @@ int at_exit(maze_t *m, walker_t *w) {
 walker_t* init_walker(maze_t *maze, direction_t (*algo)(maze_t *, walker_t *)) {
     /* static int nwalkers = 0; */
     walker_t *w = malloc(sizeof(walker_t));
-    if (!maze || !maze->maze || !w || !algo)
+    if (!maze || (!maze->cells && !maze->bits) || !w || !algo)
         return NULL;
     
     w->pos.x = maze->start.x;
     w->pos.y = maze->start.y;
+    w->idx = maze_idx(maze, w->pos);
     w->state = NULL;
     w->algo = algo;
+    w->dir = NORTH;
+    cycle_init(&w->cycle);
+    rng_seed(&w->rng, 0);
     return w;
 }
 
@@ -39,8 +47,10 @@ int move_walker(maze_t *m, walker_t *w, direction_t dir) {
     if (!w || !m)
         return 0;
     
-    if (check_move(m, w, dir))
+    if (check_move(m, w, dir)) {
         trans_point_dir(&(w->pos), dir);
+        w->idx += m->off[dir];
+    }
     return 1;
 }
 
@@ -48,9 +58,17 @@ int walker_step(maze_t *m, walker_t *w) {
     if (!m || !w)
         return 0;
     direction_t dir = w->algo(m, w);
+    if (dir == DIR_HALT)
+        return -1;
     return move_walker(m, w, dir);
 }
 
+void place_walker(maze_t *m, walker_t *w, long idx) {
+    w->idx = idx;
+    w->pos.x = idx % m->stride;
+    w->pos.y = idx / m->stride;
+}
+
 void cleanup_walker(walker_t *w) {
     if (!w)
         return;
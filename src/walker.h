@@ -13,6 +13,13 @@
 typedef struct walker_t walker_t;
 typedef struct maze_t maze_t;
 
+/*
+ * Returned by a solver function instead of a direction when the solver
+ * has proven that it will never reach the exit, for example because it
+ * walks in a circle.
+ */
+#define DIR_HALT ((direction_t) -2)
+
 /*
  * Initializes a walker.
  *
@@ -62,6 +69,15 @@ int at_exit(maze_t *m, walker_t *w);
  */
 int check_move(maze_t *m, walker_t *w, direction_t dir);
 
+/*
+ * Returns the directions the walker can move in as a mask,
+ * bit dir is set when a move in direction dir is valid.
+ *
+ * w is the walker
+ * m is the maze the walker is in
+ */
+int walker_moves(maze_t *m, walker_t *w);
+
 /*
  * Executes a single step fo a walker,
  * calculates a move and moves the walker one step
@@ -71,9 +87,19 @@ int check_move(maze_t *m, walker_t *w, direction_t dir);
  *
  * returns 1 on success
  * returns 0 on failure
+ * returns -1 if the solver halted, see DIR_HALT
  */
 int walker_step(maze_t *m, walker_t *w);
 
+/*
+ * Places a walker on the tile with index idx,
+ * used by solvers that move the walker without move_walker()
+ *
+ * w is the walker
+ * m is the maze the walker is in
+ */
+void place_walker(maze_t *m, walker_t *w, long idx);
+
 /*
  * Cleans up a walker, freeing the memory.
  *
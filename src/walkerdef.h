@@ -3,14 +3,30 @@
 #include "point.h"
 #include "walker.h"
 #include "maze.h"
+#include "kernels.h"
+#include "rng.h"
 
 struct walker_t {
     /* the position of the walker */
     point_t pos;
 
+    /* the index of pos in the cells of the maze, see mazedef.h */
+    long idx;
+
     /* the algorithm that is used to generate a new step */
     direction_t (*algo)(maze_t *, walker_t *);
 
+    /*
+     * The state of the walking solvers, kept in the walker so their
+     * kernels do not have to follow a pointer, see kernels.h
+     */
+    /* the direction of the last move */
+    direction_t dir;
+    /* detects a deterministic solver walking in a circle */
+    cycle_t cycle;
+    /* the random numbers of the random walkers */
+    rng_t rng;
+
     /*
      * The state of the walker.
      * No context is given as to what this is, 